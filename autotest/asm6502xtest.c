@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <assert.h>
+
+char v[4] = {1, 2, 3, 4};
+__zeropage char * zp;
+
+int illegalops(void)
+{
+	zp = v;
+
+	return __asm
+	{
+		ldy	#1
+		lax	(zp), y
+		inx
+		stx	v
+		lda	#$0e
+		ldx	#$0b
+		sax	v + 1
+		lda	#5
+		dcp	v + 2
+		bne	l1
+		lda	#0
+	l1:
+		sec
+		lda	#10
+		isc	v + 3
+		sta	accu
+		lda	#$ff
+		ldx	#20
+		sbx	#7
+		txa
+		clc
+		adc	accu
+		sta	accu
+		lda	#0
+		sta	accu + 1
+	};
+}
+
+struct Span
+{
+	char	a, b, c, d, e, f;
+};
+
+Span	spans[8];
+
+void fillspans(char n)
+{
+	for(char i=0; i<n; i++)
+	{
+		spans[i].a = i & 3;
+		spans[i].b = i;
+		spans[i].c = i + 1;
+		spans[i].d = i - 2;
+		spans[i].e = i;
+		spans[i].f = i;
+	}
+}
+
+char countdown(char n)
+{
+	char	s = 0;
+	volatile char	k = n;
+	while (--k)
+		s += k;
+	return s;
+}
+
+int main(void)
+{
+	assert(illegalops() == 18);
+	assert(v[0] == 3 && v[1] == 10 && v[2] == 2 && v[3] == 5);
+
+	fillspans(8);
+	for(char i=0; i<8; i++)
+	{
+		assert(spans[i].a == (i & 3));
+		assert(spans[i].b == i);
+		assert(spans[i].c == i + 1);
+		assert(spans[i].d == (char)(i - 2));
+	}
+
+	assert(countdown(10) == 45);
+
+	return 0;
+}
@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <assert.h>
+
+char v[4] = {1, 2, 3, 4};
+__zeropage char * zp;
+
+int cmosops(void)
+{
+	zp = v;
+
+	return __asm
+	{
+		stz	v
+		lda	#5
+		inc
+		inc
+		sta	v + 1
+		lda	#$0c
+		tsb	v + 2
+		lda	#$04
+		trb	v + 3
+		ldx	#7
+		ldy	#9
+		phx
+		phy
+		ldx	#0
+		ldy	#0
+		plx
+		ply
+		stx	accu
+		bra	l1
+		stz	accu
+	l1:
+		lda	(zp)
+		ora	accu
+		sta	accu
+		stz	accu + 1
+	};
+}
+
+char cmosclear(char * p, char n)
+{
+	char s = 0;
+	for(char i=0; i<n; i++)
+	{
+		s += p[i];
+		p[i] = 0;
+	}
+	return s;
+}
+
+int main(void)
+{
+	assert(cmosops() == 9);
+	assert(v[0] == 0 && v[1] == 7 && v[2] == 15 && v[3] == 0);
+
+	char	buf[10];
+	for(char i=0; i<10; i++)
+		buf[i] = i;
+	assert(cmosclear(buf, 10) == 45);
+	for(char i=0; i<10; i++)
+		assert(buf[i] == 0);
+
+	return 0;
+}
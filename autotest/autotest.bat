@@ -3,6 +3,9 @@ rem @echo off
 @call :test bitfields.cpp
 @if %errorlevel% neq 0 goto :error
 
+@call :tests heapslabtest.c
+@if %errorlevel% neq 0 goto :error
+
 @call :testn autorefreturn.cpp
 @if %errorlevel% neq 0 goto :error
 
@@ -12,6 +15,9 @@ rem @echo off
 @call :testh opp_array.cpp
 @if %errorlevel% neq 0 goto :error
 
+@call :testh opp_sort.cpp
+@if %errorlevel% neq 0 goto :error
+
 @call :testh opp_vector.cpp
 @if %errorlevel% neq 0 goto :error
 
@@ -90,6 +96,9 @@ rem @echo off
 @call :test fastcalltest.c
 @if %errorlevel% neq 0 goto :error
 
+@call :test regcalltest.c
+@if %errorlevel% neq 0 goto :error
+
 @call :test strlen.c
 @if %errorlevel% neq 0 goto :error
 
@@ -102,6 +111,15 @@ rem @echo off
 @call :test memmovetest.c
 @if %errorlevel% neq 0 goto :error
 
+@call :test selfmodtest.c
+@if %errorlevel% neq 0 goto :error
+
+@call :testn interrupttest.c
+@if %errorlevel% neq 0 goto :error
+
+@call :test bulkcopytest.c
+@if %errorlevel% neq 0 goto :error
+
 @call :test arraytest.c
 @if %errorlevel% neq 0 goto :error
 
@@ -168,12 +186,21 @@ rem @echo off
 @call :test loopboundtest.c
 @if %errorlevel% neq 0 goto :error
 
+@call :test loopnesttest.c
+@if %errorlevel% neq 0 goto :error
+
 @call :test byteindextest.c
 @if %errorlevel% neq 0 goto :error
 
 @call :test asmtest.c
 @if %errorlevel% neq 0 goto :error
 
+@call :testc asm65c02test.c
+@if %errorlevel% neq 0 goto :error
+
+@call :testx asm6502xtest.c
+@if %errorlevel% neq 0 goto :error
+
 @call :testb bitshifttest.c
 @if %errorlevel% neq 0 goto :error
 
@@ -334,6 +361,93 @@ exit /b %errorlevel%
 ..\bin\oscar64 -e -O2 -Oo -n %~1
 @if %errorlevel% neq 0 goto :error
 
+..\bin\oscar64 -e -O2 -cpu=65c02 -n %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -O2 -cpu=6502x -n %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -O2 -Ob -bc %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -Os -Ob -bc %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -O2 -nb=400 %~1
+@if %errorlevel% neq 0 goto :error
+
+@exit /b 0
+
+:testc
+..\bin\oscar64 -e -bc -cpu=65c02 %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -n -cpu=65c02 %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -O2 -bc -cpu=65c02 %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -O2 -n -cpu=65c02 %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -O0 -n -cpu=65c02 %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -Os -n -cpu=65c02 %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -O3 -n -cpu=65c02 %~1
+@if %errorlevel% neq 0 goto :error
+
+@exit /b 0
+
+:testx
+..\bin\oscar64 -e -bc -cpu=6502x %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -n -cpu=6502x %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -O2 -bc -cpu=6502x %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -O2 -n -cpu=6502x %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -O0 -n -cpu=6502x %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -Os -n -cpu=6502x %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -O3 -n -cpu=6502x %~1
+@if %errorlevel% neq 0 goto :error
+
+@exit /b 0
+
+:tests
+..\bin\oscar64 -e -bc %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -n %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -O2 -bc -dHEAPSLAB %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -O2 -n -dHEAPSLAB %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -O0 -n -dHEAPSLAB %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -Os -n -dHEAPSLAB %~1
+@if %errorlevel% neq 0 goto :error
+
+..\bin\oscar64 -e -O3 -n -dHEAPSLAB %~1
+@if %errorlevel% neq 0 goto :error
+
 @exit /b 0
 
 :testb
@@ -0,0 +1,90 @@
+#include <string.h>
+#include <assert.h>
+
+char	ba[8000], bb[8000];
+char	bm[3000];
+
+void fill(char * p, unsigned n, unsigned s)
+{
+	for(unsigned i=0; i<n; i++)
+		p[i] = (char)(i + s);
+}
+
+void check(const char * p, unsigned n, unsigned s)
+{
+	for(unsigned i=0; i<n; i++)
+		assert(p[i] == (char)(i + s));
+}
+
+void checkfill(const char * p, unsigned n, char c)
+{
+	for(unsigned i=0; i<n; i++)
+		assert(p[i] == c);
+}
+
+void testglobal(void)
+{
+	fill(ba, 8000, 3);
+	memset(bb, 0xaa, 8000);
+	checkfill(bb, 8000, 0xaa);
+
+	memcpy(bb, ba, 1000);
+	check(bb, 1000, 3);
+	checkfill(bb + 1000, 7000, 0xaa);
+
+	memcpy(bb, ba, 8000);
+	check(bb, 8000, 3);
+
+	memset(bb + 1, 0x55, 1000);
+	assert(bb[0] == 3);
+	checkfill(bb + 1, 1000, 0x55);
+	check(bb + 1001, 6999, 3 + 1001);
+
+	memclr(bb, 7777);
+	checkfill(bb, 7777, 0);
+	check(bb + 7777, 223, 3 + 7777);
+}
+
+void testindirect(char * d, const char * s)
+{
+	memset(d, 0xcc, 4000);
+	memcpy(d, s, 3333);
+	check(d, 3333, 7);
+	checkfill(d + 3333, 667, 0xcc);
+
+	memset(d, 0x11, 1000);
+	checkfill(d, 1000, 0x11);
+	check(d + 1000, 2333, 7 + 1000);
+}
+
+void testmove(int dist, unsigned n)
+{
+	fill(bm, 3000, 0);
+	memmove(bm + 500 + dist, bm + 500, n);
+
+	check(bm + 500 + dist, n, 0 + 500);
+	check(bm, 500 + dist, 0);
+	check(bm + 500 + dist + n, 3000 - 500 - dist - n, 500 + dist + n);
+}
+
+int main(void)
+{
+	testglobal();
+
+	fill(ba, 8000, 7);
+	testindirect(bb, ba);
+	testindirect(bb + 17, ba);
+
+	for(int d=-300; d<=300; d+=37)
+	{
+		testmove(d, 0);
+		testmove(d, 1);
+		testmove(d, 255);
+		testmove(d, 256);
+		testmove(d, 257);
+		testmove(d, 1000);
+		testmove(d, 1999);
+	}
+
+	return 0;
+}
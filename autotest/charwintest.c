@@ -2,6 +2,52 @@
 #include <assert.h>
 #include <stdio.h>
 
+CharWinShadow	shadow;
+
+void testshadow(void)
+{
+	CharWin	cw;
+	char	*	screen = (char *)0x0400;
+
+	cwin_init(&cw, screen, 2, 2, 32, 20);
+	cwin_clear(&cw);
+
+	cwin_init_shadow(&cw, &shadow, screen, 2, 2, 32, 20);
+
+	assert(cwin_getat_char(&cw, 5, 5) == ' ');
+
+	cwin_putat_string(&cw, 4, 3, p"hello", 7);
+	cwin_putat_char_raw(&cw, 10, 7, 1, 8);
+
+	assert(cwin_getat_char(&cw, 4, 3) == p'h');
+	assert(screen[5 * 40 + 6] == ' ');
+
+	cwin_flush(&cw);
+
+	assert(screen[5 * 40 + 6] == cwin_getat_char_raw(&cw, 4, 3));
+	assert(screen[5 * 40 + 10] == cwin_getat_char_raw(&cw, 8, 3));
+	assert(((char *)0xd800)[5 * 40 + 6] == 7);
+	assert(screen[9 * 40 + 12] == 1);
+	assert(((char *)0xd800)[9 * 40 + 12] == 8);
+
+	// Only dirty spans are copied
+	screen[5 * 40 + 2] = 0x55;
+	screen[6 * 40 + 8] = 0x56;
+
+	cwin_putat_char_raw(&cw, 7, 3, 2, 1);
+	cwin_flush(&cw);
+
+	assert(screen[5 * 40 + 9] == 2);
+	assert(screen[5 * 40 + 2] == 0x55);
+	assert(screen[6 * 40 + 8] == 0x56);
+
+	cwin_clear(&cw);
+	cwin_flush(&cw);
+
+	assert(screen[5 * 40 + 2] == ' ');
+	assert(screen[6 * 40 + 8] == ' ');
+}
+
 int main(void)
 {
 	CharWin	cw;
@@ -60,5 +106,7 @@ int main(void)
 		}		
 	}
 
+	testshadow();
+
 	return 0;
 }
@@ -80,9 +80,47 @@ void testlmul4f12s(void)
 	}
 }
 
+void testtables(void)
+{
+	for(unsigned a=0; a<256; a+=3)
+		for(unsigned b=0; b<256; b+=5)
+			assert(tmul8u(a, b) == a * b);
+
+	for(int a=-128; a<128; a+=3)
+		for(int b=-128; b<128; b+=5)
+			assert(tmul8s(a, b) == a * b);
+
+	for(int i=0; i<5000; i++)
+	{
+		unsigned	a = rand();
+		unsigned	b = rand();
+
+		assert(tmul16u(a, b) == (unsigned long)a * b);
+
+		long d = ((long)(int)a * (long)(int)b) >> 12;
+		if (d >= -32768 && d <= 32767)
+			assert(tmul4f12s(a, b) == d);
+	}
+
+	assert(tsin4f12(0) == 0);
+	assert(tsin4f12(64) == 4096);
+	assert(tcos4f12(0) == 4096);
+	assert(tcos4f12(128) == -4096);
+
+	for(unsigned a=1; a<256; a+=3)
+	{
+		for(unsigned b=1; b<=a; b+=5)
+		{
+			int	q = a / b, t = tdiv8u(a, b);
+			assert(abs(t - q) * 100 <= 3 * q + 100);
+		}
+	}
+}
+
 int main(void)
 {
 	testlmul4f12s();
+	testtables();
 	testmuldiv16u();
 	testmuldiv16s();
 
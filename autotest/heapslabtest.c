@@ -0,0 +1,82 @@
+// heapslabtest
+
+#include <stdlib.h>
+#include <string.h>
+
+struct Node
+{
+	Node	*	next;
+	int			value;
+};
+
+void smallcheck(void)
+{
+	void	*	memp[100];
+	int			mems[100];
+	int			n, k, s, i;
+	
+	for(n=0; n<100; n++)
+	{
+		s = rand() % 40;
+		mems[n] = s;
+		memp[n] = malloc(s);
+		memset(memp[n], n, s);
+	}
+	
+	for(k=0; k<2000; k++)
+	{
+		n = rand() % 100;
+		int	s = mems[n];
+		char	*	p = memp[n];
+		for(i=0; i<s; i++)
+		{
+			if (p[i] != n)
+				exit(-2);
+		}
+		free(memp[n]);
+		
+		s = rand() % 40;
+		mems[n] = s;
+		memp[n] = malloc(s);
+		if (!memp[n])
+			exit(-3);
+		memset(memp[n], n, s);
+	}
+
+	for(n=0; n<100; n++)
+		free(memp[n]);
+}
+
+void listcheck(void)
+{
+	Node	*	head = nullptr;
+
+	for(int i=0; i<200; i++)
+	{
+		Node	*	n = malloc(sizeof(Node));
+		n->value = i;
+		n->next = head;
+		head = n;
+	}
+
+	int	sum = 0;
+	while (head)
+	{
+		Node	*	n = head;
+		sum += n->value;
+		head = n->next;
+		free(n);
+	}
+
+	if (sum != 199 * 100)
+		exit(-4);
+}
+
+int main(void)
+{
+	smallcheck();
+	listcheck();
+	smallcheck();
+
+	return 0;
+}
@@ -0,0 +1,83 @@
+#include <assert.h>
+
+volatile long	la = 1000000, lb = 7;
+volatile float	fa = 1.5, fb = 2.5;
+volatile char	ca = 100;
+
+char	zp[14];
+
+__noinline long ldiv(long a, long b)
+{
+	return a / b;
+}
+
+__interrupt void irq(void)
+{
+	la = ldiv(la, lb);
+	fa = fa * fb + ca;
+	ca = ca / 3;
+}
+
+int main(void)
+{
+	// Fill the work registers with a pattern, call the interrupt
+	// and check that all of them are restored
+
+	__asm
+	{
+		ldx	#0
+	l1:
+		txa
+		eor	#$a5
+		sta	__tmp, x
+		inx
+		cpx	#8
+		bne	l1
+
+		lda	#$5a
+		sta	__tmpy
+		lda	#$11
+		sta	__accu + 0
+		lda	#$22
+		sta	__accu + 1
+		lda	#$33
+		sta	__accu + 2
+		lda	#$44
+		sta	__accu + 3
+
+		jsr	irq
+
+		ldx	#0
+	l2:
+		lda	__tmp, x
+		sta	zp, x
+		inx
+		cpx	#8
+		bne	l2
+
+		lda	__tmpy
+		sta	zp + 8
+		lda	__accu + 0
+		sta	zp + 9
+		lda	__accu + 1
+		sta	zp + 10
+		lda	__accu + 2
+		sta	zp + 11
+		lda	__accu + 3
+		sta	zp + 12
+	}
+
+	for(char i=0; i<8; i++)
+		assert(zp[i] == (i ^ 0xa5));
+	assert(zp[8] == 0x5a);
+	assert(zp[9] == 0x11);
+	assert(zp[10] == 0x22);
+	assert(zp[11] == 0x33);
+	assert(zp[12] == 0x44);
+
+	assert(la == 1000000 / 7);
+	assert(fa == 1.5 * 2.5 + 100);
+	assert(ca == 33);
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+#include <assert.h>
+
+char	grid[8][16];
+char	tab[16] = {3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5, 8, 9, 7, 9, 3};
+char	hist[16];
+
+__noinline void fill(char k)
+{
+	char	n = 0;
+	for(char i=0; i<8; i++)
+	{
+		for(char j=0; j<16; j++)
+		{
+			grid[i][j] = tab[j] + n;
+			n += k;
+		}
+	}
+}
+
+__noinline unsigned count(char m)
+{
+	unsigned	s = 0;
+	char		c = 0;
+	for(char i=0; i<8; i++)
+	{
+		for(char j=0; j<16; j++)
+		{
+			if (grid[i][j] & m)
+			{
+				hist[j]++;
+				c++;
+			}
+		}
+		s += c;
+	}
+	return s;
+}
+
+__noinline char deep(char n)
+{
+	char	t = 0;
+	for(char i=0; i<n; i++)
+		for(char j=0; j<n; j++)
+			for(char k=0; k<n; k++)
+				t += tab[k] ^ j;
+	return t;
+}
+
+int main(void)
+{
+	fill(3);
+
+	char	n = 0;
+	for(char i=0; i<8; i++)
+	{
+		for(char j=0; j<16; j++)
+		{
+			assert(grid[i][j] == (char)(tab[j] + n));
+			n += 3;
+		}
+	}
+
+	unsigned	s = 0, c = 0;
+	char		h[16];
+	for(char j=0; j<16; j++)
+		h[j] = 0;
+	for(char i=0; i<8; i++)
+	{
+		for(char j=0; j<16; j++)
+		{
+			if (grid[i][j] & 5)
+			{
+				h[j]++;
+				c++;
+			}
+		}
+		s += c;
+	}
+
+	assert(count(5) == s);
+	for(char j=0; j<16; j++)
+		assert(hist[j] == h[j]);
+
+	char	t = 0;
+	for(char i=0; i<10; i++)
+		for(char j=0; j<10; j++)
+			for(char k=0; k<10; k++)
+				t += tab[k] ^ j;
+
+	assert(deep(10) == t);
+
+	return 0;
+}
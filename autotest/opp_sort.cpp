@@ -0,0 +1,87 @@
+#include <opp/vector.h>
+#include <opp/array.h>
+#include <opp/algorithm.h>
+#include <stdlib.h>
+#include <assert.h>
+
+using namespace opp;
+
+template<class T>
+void check_sorted(T s, T e)
+{
+	if (s != e)
+	{
+		T p = s;
+		s++;
+		while (s != e)
+		{
+			assert(!(*s < *p));
+			p = s;
+			s++;
+		}
+	}
+}
+
+void test_vector(int n, char mode)
+{
+	vector<int>	v;
+	long		sum = 0;
+
+	for(int i=0; i<n; i++)
+	{
+		int	k;
+		switch (mode)
+		{
+		case 0:
+			k = i;
+			break;
+		case 1:
+			k = n - i;
+			break;
+		case 2:
+			k = rand() & 15;
+			break;
+		case 3:
+			k = 7;
+			break;
+		default:
+			k = rand();
+			break;
+		}
+		v.push_back(k);
+		sum += k;
+	}
+
+	sort(v.begin(), v.end(), [](int a, int b) {return a < b;});
+
+	check_sorted(v.begin(), v.end());
+	for(int i=0; i<n; i++)
+		sum -= v[i];
+	assert(sum == 0);
+}
+
+void test_array(void)
+{
+	array<char, 100>	a;
+
+	for(int i=0; i<100; i++)
+		a[i] = (i * 37) % 100;
+
+	sort(a.begin(), a.end(), [](char a, char b) {return a > b;});
+
+	for(int i=0; i<100; i++)
+		assert(a[i] == 99 - i);
+}
+
+int main(void)
+{
+	static const int sizes[] = {0, 1, 2, 3, 12, 13, 50, 300};
+
+	for(char i=0; i<8; i++)
+		for(char m=0; m<5; m++)
+			test_vector(sizes[i], m);
+
+	test_array();
+
+	return 0;
+}
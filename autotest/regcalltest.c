@@ -0,0 +1,52 @@
+#include <assert.h>
+
+char	buffer[10];
+
+__noinline char add3(char a, char b, char c)
+{
+	return a + b * 2 + c * 3;
+}
+
+__noinline char sub2(char a, char b)
+{
+	return a - b;
+}
+
+__noinline int twice(int a)
+{
+	return a + a;
+}
+
+__noinline char * skip(char * p)
+{
+	return p + 2;
+}
+
+__noinline int mix(char a, int b)
+{
+	return b - a;
+}
+
+__noinline int outer(char a, char b, char c)
+{
+	return twice(add3(c, b, a)) + mix(a, sub2(b, c));
+}
+
+int main(void)
+{
+	for(char i=0; i<10; i++)
+	{
+		for(char j=0; j<10; j++)
+		{
+			assert(add3(i, j, i + j) == i + 2 * j + 3 * (i + j));
+			assert(sub2(i, j) == (char)(i - j));
+			assert(outer(i, j, 3) == 2 * (3 + 2 * j + 3 * i) + (char)(j - 3) - i);
+		}
+
+		assert(twice(i * 1000) == 2000 * i);
+		assert(mix(i, -1000) == -1000 - i);
+		assert(skip(buffer + i) == buffer + i + 2);
+	}
+
+	return 0;
+}
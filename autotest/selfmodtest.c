@@ -0,0 +1,74 @@
+#include <assert.h>
+#include <string.h>
+
+#pragma optimize(push, selfmodify)
+
+char a[300], b[300];
+
+__noinline void copy(char * d, const char * s, char n)
+{
+	for(char i=0; i<n; i++)
+		d[i] = s[i];
+}
+
+void ormask(char * d, const char * s, char w, char h)
+{
+	for(char y=0; y<h; y++)
+	{
+		for(char x=0; x<w; x++)
+			d[x] |= s[x];
+		d += 40;
+		s += w;
+	}
+}
+
+__noinline unsigned sum(const char * s, char n)
+{
+	unsigned	t = 0;
+	for(char i=0; i<n; i++)
+		t += s[i];
+	return t;
+}
+
+void addto(char * d, const char * s, char k)
+{
+	char i = 0;
+	do {
+		d[i] = s[i] + k;
+		i++;
+	} while (i != 100);
+}
+
+#pragma optimize(pop)
+
+int main(void)
+{
+	for(int i=0; i<300; i++)
+		a[i] = i;
+
+	copy(b, a, 200);
+	for(int i=0; i<200; i++)
+		assert(b[i] == (char)i);
+
+	copy(b, a + 100, 200);
+	for(int i=0; i<200; i++)
+		assert(b[i] == (char)(i + 100));
+
+	copy(b + 250, a, 0);
+	assert(b[250] == 0);
+
+	assert(sum(a, 100) == 4950);
+	assert(sum(a + 1, 100) == 5050);
+
+	memset(b, 0, 300);
+	ormask(b, a, 20, 6);
+	for(int y=0; y<6; y++)
+		for(int x=0; x<20; x++)
+			assert(b[40 * y + x] == (char)(20 * y + x));
+
+	addto(b, a + 40, 3);
+	for(int i=0; i<100; i++)
+		assert(b[i] == (char)(i + 43));
+
+	return 0;
+}
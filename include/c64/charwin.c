@@ -1,4 +1,5 @@
 #include "charwin.h"
+#include <c64/vic.h>
 
 
 static const unsigned mul40[25] = {
@@ -37,6 +38,34 @@ static __native inline void copy_bwd(char * sdp, const char * ssp, char * cdp, c
 	}
 }
 
+// Extend the dirty span of a row of a shadowed window
+static inline void mark_span(CharWin * win, char x, char y, char w)
+{
+	CharWinShadow	*	s = win->shadow;
+	if (s)
+	{
+		if (x < s->dleft[y])
+			s->dleft[y] = x;
+		x += w;
+		if (x > s->dright[y])
+			s->dright[y] = x;
+	}
+}
+
+// Mark full rows of a shadowed window as dirty
+static void mark_rows(CharWin * win, char y, char h)
+{
+	CharWinShadow	*	s = win->shadow;
+	if (s)
+	{
+		for(char i=0; i<h; i++)
+		{
+			s->dleft[y + i] = 0;
+			s->dright[y + i] = win->wx;
+		}
+	}
+}
+
 
 void cwin_init(CharWin * win, char * screen, char sx, char sy, char wx, char wy)
 {
@@ -48,6 +77,59 @@ void cwin_init(CharWin * win, char * screen, char sx, char sy, char wx, char wy)
 	win->cy = 0;
 	win->sp = screen + mul40[sy] + sx;
 	win->cp = (char *)0xd800 + mul40[sy] + sx;
+	win->shadow = nullptr;
+	win->dsp = win->sp;
+	win->dcp = win->cp;
+}
+
+void cwin_init_shadow(CharWin * win, CharWinShadow * shadow, char * screen, char sx, char sy, char wx, char wy)
+{
+	cwin_init(win, screen, sx, sy, wx, wy);
+
+	win->shadow = shadow;
+	win->sp = shadow->screen + mul40[sy] + sx;
+	win->cp = shadow->color + mul40[sy] + sx;
+
+	char	*	sp = win->sp, * cp = win->cp;
+	char	*	dsp = win->dsp, * dcp = win->dcp;
+	for(char y=0; y<wy; y++)
+	{
+		copy_fwd(sp, dsp, cp, dcp, wx);
+		shadow->dleft[y] = 255;
+		shadow->dright[y] = 0;
+		sp += 40; cp += 40;
+		dsp += 40; dcp += 40;
+	}
+}
+
+void cwin_flush(CharWin * win)
+{
+	CharWinShadow	*	s = win->shadow;
+	if (s)
+	{
+		char	*	sp = win->sp, * cp = win->cp;
+		char	*	dsp = win->dsp, * dcp = win->dcp;
+		for(char y=0; y<win->wy; y++)
+		{
+			char	l = s->dleft[y], r = s->dright[y];
+			if (l < r)
+			{
+				copy_fwd(dsp + l, sp + l, dcp + l, cp + l, r - l);
+				s->dleft[y] = 255;
+				s->dright[y] = 0;
+			}
+			sp += 40; cp += 40;
+			dsp += 40; dcp += 40;
+		}
+	}
+}
+
+#pragma native(cwin_flush)
+
+void cwin_flush_sync(CharWin * win)
+{
+	vic_waitBottom();
+	cwin_flush(win);
 }
 
 
@@ -65,6 +147,7 @@ void cwin_fill(CharWin * win, char ch, char color)
 		sp += 40;
 		cp += 40;
 	}
+	mark_rows(win, 0, win->wy);
 }
 
 
@@ -75,6 +158,7 @@ void cwin_cursor_show(CharWin * win, bool show)
 		*cp |= 0x80;
 	else
 		*cp &= 0x7f;
+	mark_span(win, win->cx, win->cy, 1);
 }
 
 void cwin_cursor_move(CharWin * win, char cx, char cy)
@@ -225,7 +309,7 @@ void cwin_write_string(CharWin * win, const char * buffer)
 		}
 		dp += 40;
 	}	
-
+	mark_rows(win, 0, win->wy);
 }
 void cwin_put_char(CharWin * win, char ch, char color)
 {
@@ -304,6 +388,7 @@ void cwin_putat_char(CharWin * win, char x, char y, char ch, char color)
 
 	win->sp[offset] = p2s(ch);
 	win->cp[offset] = color;
+	mark_span(win, x, y, 1);
 }
 
 #pragma native(cwin_putat_char)
@@ -322,6 +407,7 @@ void cwin_putat_chars(CharWin * win, char x, char y, const char * chars, char nu
 		sp[i] = p2s(ch);
 		cp[i] = color;
 	}
+	mark_span(win, x, y, num);
 }
 
 #pragma native(cwin_putat_chars)
@@ -340,6 +426,7 @@ char cwin_putat_string(CharWin * win, char x, char y, const char * str, char col
 		cp[i] = color;
 		i++;
 	}
+	mark_span(win, x, y, i);
 
 	return i;
 }
@@ -352,6 +439,7 @@ void cwin_putat_char_raw(CharWin * win, char x, char y, char ch, char color)
 
 	win->sp[offset] = ch;
 	win->cp[offset] = color;
+	mark_span(win, x, y, 1);
 }
 
 #pragma native(cwin_putat_char_raw)
@@ -370,6 +458,7 @@ void cwin_putat_chars_raw(CharWin * win, char x, char y, const char * chars, cha
 		sp[i] = ch;
 		cp[i] = color;
 	}
+	mark_span(win, x, y, num);
 }
 
 #pragma native(cwin_putat_chars_raw)
@@ -388,6 +477,7 @@ char cwin_putat_string_raw(CharWin * win, char x, char y, const char * str, char
 		cp[i] = color;
 		i++;
 	}
+	mark_span(win, x, y, i);
 
 	return i;
 }
@@ -456,6 +546,7 @@ void cwin_put_rect_raw(CharWin * win, char x, char y, char w, char h, const char
 		chars += w;
 		sp += 40;
 		cp += 40;
+		mark_span(win, x, y + i, w);
 	}
 }
 
@@ -480,6 +571,7 @@ void cwin_put_rect(CharWin * win, char x, char y, char w, char h, const char * c
 		chars += w;
 		sp += 40;
 		cp += 40;
+		mark_span(win, x, y + i, w);
 	}
 }
 
@@ -553,6 +645,8 @@ void cwin_insert_char(CharWin * win)
 	copy_bwd(sp + 1, sp, cp + 1, cp, rx);
 
 	sp[0] = ' ';
+
+	mark_rows(win, win->cy, win->wy - win->cy);
 }
 
 void cwin_delete_char(CharWin * win)
@@ -579,6 +673,8 @@ void cwin_delete_char(CharWin * win)
 	}
 
 	sp[rx] = ' ';
+
+	mark_rows(win, win->cy, win->wy - win->cy);
 }
 
 int cwin_getch(void)
@@ -684,6 +780,7 @@ void cwin_scroll_left(CharWin * win, char by)
 	{
 		copy_fwd(sp, sp + by, cp, cp + by, rx);
 	}
+	mark_rows(win, 0, win->wy);
 }
 
 void cwin_scroll_right(CharWin * win, char by)
@@ -699,6 +796,7 @@ void cwin_scroll_right(CharWin * win, char by)
 		sp += 40;
 		cp += 40;
 	}
+	mark_rows(win, 0, win->wy);
 }
 
 void cwin_scroll_up(CharWin * win, char by)
@@ -715,6 +813,7 @@ void cwin_scroll_up(CharWin * win, char by)
 		sp += 40;
 		cp += 40;
 	}	
+	mark_rows(win, 0, win->wy);
 }
 
 void cwin_scroll_down(CharWin * win, char by)
@@ -732,6 +831,7 @@ void cwin_scroll_down(CharWin * win, char by)
 		cp -= 40;
 		copy_fwd(sp, sp - dst, cp, cp - dst, rx);
 	}	
+	mark_rows(win, 0, win->wy);
 }
 
 void cwin_fill_rect_raw(CharWin * win, char x, char y, char w, char h, char ch, char color)
@@ -747,6 +847,8 @@ void cwin_fill_rect_raw(CharWin * win, char x, char y, char w, char h, char ch,
 			sp += 40;
 			cp += 40;		
 		}
+		for(char i=0; i<h; i++)
+			mark_span(win, x, y + i, w);
 	}
 }
 
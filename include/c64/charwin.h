@@ -1,12 +1,23 @@
 #ifndef C64_CHARWIN_H
 #define C64_CHARWIN_H
 
+// Off screen copy of screen and color RAM for a shadowed CharWin, with
+// the dirty span of each window row
+struct CharWinShadow
+{
+	char		screen[1000], color[1000];
+	char		dleft[25], dright[25];
+};
+
 struct CharWin
 {
 	char		sx, sy, wx, wy;
 	char		cx, cy;
 
 	char	*	sp, * cp;
+
+	CharWinShadow	*	shadow;
+	char			*	dsp, * dcp;
 };
 
 // Initialize the CharWin structure for the given screen and coordinates, does
@@ -14,6 +25,21 @@ struct CharWin
 //
 void cwin_init(CharWin * win, char * screen, char sx, char sy, char wx, char wy);
 
+// Initialize the CharWin structure to draw into an off screen shadow buffer, the
+// current window content is copied into the shadow.  Changes become visible with
+// the next cwin_flush
+//
+void cwin_init_shadow(CharWin * win, CharWinShadow * shadow, char * screen, char sx, char sy, char wx, char wy);
+
+// Copy the changed spans of a shadowed window to the screen, does nothing
+// for a window without shadow.  Can be called from a raster interrupt
+//
+void cwin_flush(CharWin * win);
+
+// Wait for the bottom of the screen and flush the window
+//
+void cwin_flush_sync(CharWin * win);
+
 
 // Clear the window
 //
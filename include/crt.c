@@ -4558,8 +4558,154 @@ struct Heap {
 
 #pragma section(heap, 0x0000, HeapStart, HeapEnd)
 
+#ifdef HEAPCHECK
+#undef HEAPSLAB
+#endif
+
+#ifdef HEAPSLAB
+
+// Free lists of the three small size classes with a payload of up to
+// 6, 14 and 30 bytes.  Each slab block has a two byte header with the
+// size class index and a zero, so free can tell it from a heap block.
+// The free lists point to the payload, with the link to the next free
+// block stored in the first two bytes of the payload.
+
+char	*	HeapSlab[3];
+
+#endif
+
 __asm crt_malloc
 {
+#ifdef HEAPSLAB
+		// small allocations are served from the slab
+		// free lists
+
+		lda accu + 1
+		bne large
+		lda accu
+		cmp #7
+		bcc slab0
+		cmp #15
+		bcc slab1
+		cmp #31
+		bcc slab2
+large:
+		jmp heap
+
+		// entry points for the size classes, x holds
+		// the index into the free list table
+
+slab2:
+		ldx #4
+		bne slab
+slab1:
+		ldx #2
+		bne slab
+slab0:
+		ldx #0
+slab:
+		// check for empty free list
+
+		lda HeapSlab + 1, x
+		beq refill
+
+		// unlink first block from free list
+
+		sta accu + 1
+		lda HeapSlab, x
+		sta accu
+		ldy #0
+		lda (accu), y
+		sta HeapSlab, x
+		iny
+		lda (accu), y
+		sta HeapSlab + 1, x
+		rts
+
+refill:
+		// allocate a chunk of 128 bytes from the heap
+		// and split it into blocks of the size class
+
+		txa
+		pha
+		lda #128 - 2
+		sta accu
+		lda #0
+		sta accu + 1
+		jsr heap
+		pla
+		tax
+
+		lda accu + 1
+		bne chunk
+		rts
+chunk:
+		// block size in tmp, number of blocks in tmp + 1
+
+		lda #8
+		ldy #16
+		cpx #2
+		bcc csize
+		lda #16
+		ldy #8
+		cpx #4
+		bcc csize
+		lda #32
+		ldy #4
+csize:
+		sta tmp
+		sty tmp + 1
+
+		// the chunk starts two bytes before the returned
+		// pointer, reusing the heap block header
+
+		sec
+		lda accu
+		sbc #2
+		sta accu
+		bcs carve
+		dec accu + 1
+carve:
+		// write block header
+
+		ldy #0
+		txa
+		sta (accu), y
+		iny
+		lda #0
+		sta (accu), y
+
+		// link payload into free list
+
+		iny
+		lda HeapSlab, x
+		sta (accu), y
+		iny
+		lda HeapSlab + 1, x
+		sta (accu), y
+
+		clc
+		lda accu
+		adc #2
+		sta HeapSlab, x
+		lda accu + 1
+		adc #0
+		sta HeapSlab + 1, x
+
+		// next block
+
+		clc
+		lda accu
+		adc tmp
+		sta accu
+		bcc cnext
+		inc accu + 1
+cnext:
+		dec tmp + 1
+		bne carve
+		jmp slab
+heap:
+#endif
 		// make room for two additional bytes
 		// to store pointer to end of used memory
 		// in case of heap check we add six bytes to
@@ -4820,6 +4966,37 @@ notnull:
 		dec accu + 1
 fc1:
 
+#ifdef HEAPSLAB
+		// a zero high byte in the header marks a slab
+		// block, the low byte is the size class
+
+		ldy #1
+		lda (accu), y
+		bne noslab
+		dey
+		lda (accu), y
+		tax
+
+		// link into free list of size class
+
+		ldy #2
+		lda HeapSlab, x
+		sta (accu), y
+		iny
+		lda HeapSlab + 1, x
+		sta (accu), y
+
+		clc
+		lda accu
+		adc #2
+		sta HeapSlab, x
+		lda accu + 1
+		adc #0
+		sta HeapSlab + 1, x
+		rts
+noslab:
+#endif
+
 #ifdef HEAPCHECK
 		ldy #2
 		lda #$bd
@@ -5023,6 +5200,11 @@ __asm crt_breakpoint
 
 #pragma runtime(malloc, crt_malloc)
 #pragma runtime(free, crt_free)
+#ifdef HEAPSLAB
+#pragma runtime(mallocslab0, crt_malloc.slab0)
+#pragma runtime(mallocslab1, crt_malloc.slab1)
+#pragma runtime(mallocslab2, crt_malloc.slab2)
+#endif
 #pragma runtime(breakpoint, crt_breakpoint)
 
 #if 0
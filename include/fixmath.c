@@ -1,4 +1,5 @@
 #include "fixmath.h"
+#include <math.h>
 
 unsigned long lmul16u(unsigned x, unsigned y)
 {
@@ -909,3 +910,92 @@ __native long ldiv16f16s(long x, long y)
 	else
 		return x;
 }
+
+__striped const unsigned fixtab_qsq[512] = {
+#for(i,512) (unsigned)((long)i * i / 4),
+};
+
+__striped const int fixtab_sin[256] = {
+#for(i,256) (int)(4096 * sin(i * (PI / 128)) + (i < 128 ? 0.5 : -0.5)),
+};
+
+const char fixtab_log2[256] = {
+	0,
+#for(i,255) i < 253 ? (char)(32 * log(i + 1) / log(2) + 0.5) : 255,
+};
+
+const char fixtab_exp2[256] = {
+#for(i,256) (char)(exp(i * (0.6931472 / 32)) + 0.5),
+};
+
+#pragma align(fixtab_qsq, 256)
+#pragma align(fixtab_sin, 256)
+#pragma align(fixtab_log2, 256)
+#pragma align(fixtab_exp2, 256)
+
+__native unsigned tmul8u(char x, char y)
+{
+	// x * y = ((x + y)^2 - (x - y)^2) / 4, the rounding of the
+	// quarter squares cancels, because both have the same parity
+
+	unsigned	s = x + y;
+	char		d = x > y ? x - y : y - x;
+	return fixtab_qsq[s] - fixtab_qsq[d];
+}
+
+__native int tmul8s(signed char x, signed char y)
+{
+	int	s = x + y;
+	int	d = x - y;
+	if (s < 0) s = -s;
+	if (d < 0) d = -d;
+	return fixtab_qsq[s] - fixtab_qsq[d];
+}
+
+unsigned long tmul16u(unsigned x, unsigned y)
+{
+	char	xl = x & 0xff, xh = x >> 8;
+	char	yl = y & 0xff, yh = y >> 8;
+
+	unsigned long	m = tmul8u(xl, yh) + (unsigned long)tmul8u(xh, yl);
+
+	return tmul8u(xl, yl) + (m << 8) + ((unsigned long)tmul8u(xh, yh) << 16);
+}
+
+int tmul4f12s(int x, int y)
+{
+	bool	sign = false;
+	if (x < 0)
+	{
+		x = -x;
+		sign = true;
+	}
+	if (y < 0)
+	{
+		y = -y;
+		sign = !sign;
+	}
+
+	long	r = tmul16u(x, y);
+	if (sign)
+		r = -r;
+	return (int)(r >> 12);
+}
+
+__native int tsin4f12(char a)
+{
+	return fixtab_sin[a];
+}
+
+__native int tcos4f12(char a)
+{
+	return fixtab_sin[(char)(a + 64)];
+}
+
+__native char tdiv8u(char x, char y)
+{
+	if (x < y)
+		return 0;
+	else
+		return fixtab_exp2[fixtab_log2[x] - fixtab_log2[y]];
+}
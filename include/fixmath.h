@@ -58,6 +58,41 @@ __native unsigned long ldiv16f16(unsigned long x, unsigned long y);
 
 __native long ldiv16f16s(long x, long y);
 
+// Table driven fast math, the tables are generated at compile time, page
+// aligned and only linked when used.  The striped tables can only be
+// accessed from native code.  Define FIXMATH_TABLES to use them in the
+// fixpoint routines of other libraries, e.g. gfx/vector3d.c
+
+// Quarter squares n * n / 4 for n = 0..511
+extern __striped const unsigned fixtab_qsq[512];
+
+// Sine in 4.12 fixpoint for 256 steps per full circle
+extern __striped const int fixtab_sin[256];
+
+// Binary logarithm of 1..255 in 3.5 fixpoint, and the inverse
+extern const char fixtab_log2[256];
+extern const char fixtab_exp2[256];
+
+// Multiply two unsigned 8bit numbers using quarter squares
+__native unsigned tmul8u(char x, char y);
+
+// Multiply two signed 8bit numbers using quarter squares
+__native int tmul8s(signed char x, signed char y);
+
+// Multiply two unsigned 16bit numbers using quarter squares
+__native unsigned long tmul16u(unsigned x, unsigned y);
+
+// Multiply two 4.12 fixpoint numbers using quarter squares
+__native int tmul4f12s(int x, int y);
+
+// Sine and cosine of an angle with 256 steps per full circle as 4.12 fixpoint
+__native int tsin4f12(char a);
+
+__native int tcos4f12(char a);
+
+// Approximate quotient of two unsigned 8bit numbers using log and exp
+// tables, the relative error is about three percent
+__native char tdiv8u(char x, char y);
 
 #pragma compile("fixmath.c")
 
@@ -2,6 +2,10 @@
 #include <math.h>
 #include <fixmath.h>
 
+#ifdef FIXMATH_TABLES
+#define lmul4f12s	tmul4f12s
+#endif
+
 void vec2_set(Vector2 * vd, float x, float y)
 {
 	vd->v[0] = x;
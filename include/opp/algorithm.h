@@ -4,34 +4,175 @@
 #include "utility.h"
 namespace opp {
 
-template<class T, class LT>
-void sort(T s, T e)
+// Generic sort for forward iterators, partition around the first
+// element, recurse into the left and iterate over the right part
+
+template<class T, class LF>
+struct sort_range
 {
-	while (s != e)
+	static void sort(T s, T e, LF lt)
 	{
-		auto p = s;
-		auto q = s;
+		while (s != e)
+		{
+			auto p = s;
+			auto q = s;
 
-		q++;
-		while (q != e)
+			q++;
+			while (q != e)
+			{
+				if (lt(*q, *p))
+				{
+					swap(*q, *p);
+					p++;
+					swap(*q, *p);				
+				}
+				q++;
+			}
+
+			sort(s, p, lt);
+			p++;
+			s = p;
+		}
+	}
+};
+
+// Introsort for random access iterators, median of three quicksort
+// with a depth limit, heapsort fallback and insertion sort for short
+// ranges.  Uses no recursion to preserve the software stack.
+
+static constexpr int sort_threshold = 12;
+
+template<class T, class LF>
+struct sort_range<T *, LF>
+{
+	static void insertion(T * s, T * e, LF lt)
+	{
+		for(T * i = s + 1; i < e; i++)
 		{
-			if (LT(*q, *p))
+			if (lt(*i, i[-1]))
 			{
-				swap(*q, *p);
-				p++;
-				swap(*q, *p);				
+				T	t(move(*i));
+				T * j = i;
+				do {
+					*j = move(j[-1]);
+					j--;
+				} while (j != s && lt(t, j[-1]));
+				*j = move(t);
 			}
-			q++;
 		}
+	}
 
-		sort<T, LT>(s, p);
-		p++;
-		s = p;
+	static void sift(T * s, int i, int n, LF lt)
+	{
+		for(;;)
+		{
+			int c = 2 * i + 1;
+			if (c >= n)
+				return;
+			if (c + 1 < n && lt(s[c], s[c + 1]))
+				c++;
+			if (!lt(s[i], s[c]))
+				return;
+			swap(s[i], s[c]);
+			i = c;
+		}
 	}
-}
 
-template<class T, class LF>
-void sort(T s, T e, LF lt)
+	static void heap(T * s, T * e, LF lt)
+	{
+		int	n = e - s;
+		for(int i=n / 2; i > 0; i--)
+			sift(s, i - 1, n, lt);
+		while (n > 1)
+		{
+			n--;
+			swap(s[0], s[n]);
+			sift(s, 0, n, lt);
+		}
+	}
+
+	static void sort(T * s, T * e, LF lt)
+	{
+		// Pending ranges, the larger part is pushed and the smaller
+		// one processed first, so the depth is logarithmic
+
+		T	*	rstack[32];
+		char	dstack[16];
+		char	sp = 0;
+
+		char	depth = 0;
+		for(int n = e - s; n > 1; n >>= 1)
+			depth += 2;
+
+		for(;;)
+		{
+			if (e - s > sort_threshold)
+			{
+				if (depth == 0)
+					heap(s, e, lt);
+				else
+				{
+					depth--;
+
+					// Order first, middle and last element, the last one
+					// stops the left scan of the partition
+
+					T * m = s + ((e - s) >> 1);
+					T * l = e - 1;
+					if (lt(*m, *s))
+						swap(*m, *s);
+					if (lt(*l, *m))
+					{
+						swap(*l, *m);
+						if (lt(*m, *s))
+							swap(*m, *s);
+					}
+
+					// Move median to front and partition the remaining range
+
+					swap(*s, *m);
+					T * i = s, * j = e;
+					for(;;)
+					{
+						do i++; while (lt(*i, *s));
+						do j--; while (lt(*s, *j));
+						if (i >= j)
+							break;
+						swap(*i, *j);
+					}
+					swap(*s, *j);
+
+					dstack[sp >> 1] = depth;
+					if (j - s < e - j)
+					{
+						rstack[sp++] = j + 1;
+						rstack[sp++] = e;
+						e = j;
+					}
+					else
+					{
+						rstack[sp++] = s;
+						rstack[sp++] = j;
+						s = j + 1;
+					}
+					continue;
+				}
+			}
+			else
+				insertion(s, e, lt);
+
+			if (sp == 0)
+				return;
+
+			e = rstack[--sp];
+			s = rstack[--sp];
+			depth = dstack[sp >> 1];
+		}
+	}
+};
+
+template<class T, class LT>
+void sort(T s, T e)
 {
 	while (s != e)
 	{
@@ -41,7 +182,7 @@ void sort(T s, T e, LF lt)
 		q++;
 		while (q != e)
 		{
-			if (lt(*q, *p))
+			if (LT(*q, *p))
 			{
 				swap(*q, *p);
 				p++;
@@ -50,12 +191,18 @@ void sort(T s, T e, LF lt)
 			q++;
 		}
 
-		sort(s, p, lt);
+		sort<T, LT>(s, p);
 		p++;
 		s = p;
 	}
 }
 
+template<class T, class LF>
+void sort(T s, T e, LF lt)
+{
+	sort_range<T, LF>::sort(s, e, lt);
+}
+
 template<class II, class OI>
 OI copy(II first, II last, OI result)
 {
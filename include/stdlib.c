@@ -531,15 +531,33 @@ extern struct Heap {
 	Heap	*	next, * end;
 }	HeapNode;
 
+#if defined(HEAPSLAB) && !defined(HEAPCHECK)
+extern char	*	HeapSlab[3];
+#endif
+
 unsigned heapfree(void)
 {
+	// The heap is only modified by the runtime, so read the list heads
+	// through volatile pointers to avoid forwarding across malloc/free
+
 	unsigned	avail = 0;
-	Heap	*	h = HeapNode.next;
+	Heap	*	h = *(Heap * volatile *)&HeapNode.next;
 	while (h)
 	{
 		avail += (h->end - h) * sizeof(Heap);
 		h = h->next;
 	}
+#if defined(HEAPSLAB) && !defined(HEAPCHECK)
+	for(char i=0; i<3; i++)
+	{
+		char	**	p = *(char ** volatile *)(HeapSlab + i);
+		while (p)
+		{
+			avail += 8 << i;
+			p = (char **)*p;
+		}
+	}
+#endif
 	return avail;
 }
 
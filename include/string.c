@@ -183,9 +183,29 @@ void * memset(void * dst, int value, int size)
 
 void * memclr(void * dst, int size)
 {
-	char	*	d = dst;
-	while (size--)
-		*d++ = 0;
+	__asm
+	{
+			lda	#0
+
+			ldx	size + 1
+			beq	_w1
+			ldy	#0
+	_loop1:
+			sta (dst), y
+			iny
+			bne	_loop1
+			inc dst + 1
+			dex
+			bne	_loop1
+	_w1:
+			ldy	size
+			beq	_w2
+	_loop2:
+			dey
+			sta (dst), y
+			bne _loop2
+	_w2:
+	}
 	return dst;
 }	
 
@@ -234,29 +254,81 @@ void * memcpy(void * dst, const void * src, int size)
 
 void * memmove(void * dst, const void * src, int size)
 {	
-	int	sz = size;
-	if (sz > 0)
+	__asm
 	{
-		char		*	d = (char *)dst;
-		const char	*	s = (const char *)src;
-		if (d < s)
-		{
-			do {
-				*d++ = *s++;
-			} while (--sz);
-		}
-		else if (d > s)
-		{
-			d += sz;
-			s += sz;
-			do {
-				*--d = *--s;
-			} while (--sz);
-		}	
+			lda	size + 1
+			bmi	_done
+
+			lda	dst + 1
+			cmp	src + 1
+			bne	_w0
+			lda	dst
+			cmp	src
+	_w0:
+			bcs	_back
+
+			ldy	#0
+			ldx	size + 1
+			beq	_wf1
+	_loopf1:
+			lda (src), y
+			sta (dst), y
+			iny
+			bne	_loopf1
+			inc src + 1
+			inc dst + 1
+			dex
+			bne	_loopf1
+	_wf1:
+			ldx	size
+			beq	_done
+	_loopf2:
+			lda (src), y
+			sta (dst), y
+			iny
+			dex
+			bne	_loopf2
+			jmp	_done
+
+	_back:
+			clc
+			lda	src + 1
+			adc	size + 1
+			sta	src + 1
+			clc
+			lda	dst + 1
+			adc	size + 1
+			sta	dst + 1
+
+			ldy	size
+			beq	_wb1
+	_loopb1:
+			dey
+			lda (src), y
+			sta (dst), y
+			cpy	#0
+			bne	_loopb1
+	_wb1:
+			ldx	size + 1
+			beq	_done
+	_loopb2:
+			dec	src + 1
+			dec	dst + 1
+	_loopb3:
+			dey
+			lda (src), y
+			sta (dst), y
+			cpy	#0
+			bne	_loopb3
+			dex
+			bne	_loopb2
+	_done:
 	}
 	return dst;
 }
 
+#pragma native(memmove)
+
 int memcmp(const void * ptr1, const void * ptr2, int size)
 {
 	const char	*	p = (const char *)ptr1, * q = (const char *)ptr2;
@@ -290,6 +290,8 @@ const char* AsmInstructionNames[NUM_ASM_INS_TYPES] = {
 	"CLD", "CLI", "CLV", "CMP", "CPX", "CPY", "DEC", "DEX", "DEY", "EOR", "INC", "INX", "INY", "JMP",
 	"JSR", "LDA", "LDX", "LDY", "LSR", "NOP", "ORA", "PHA", "PHP", "PLA", "PLP", "ROL", "ROR", "RTI",
 	"RTS", "SBC", "SEC", "SED", "SEI", "STA", "STX", "STY", "TAX", "TAY", "TSX", "TXA", "TXS", "TYA",
+	"BRA", "PHX", "PHY", "PLX", "PLY", "STZ", "TRB", "TSB",
+	"DCP", "ISC", "LAX", "SAX", "SBX",
 	"INV", "BYT"
 };
 
@@ -306,6 +308,7 @@ int AsmInsModeSize[NUM_ASM_INS_MODES_X] = {
 	2,
 	2,
 	2,
+	2,
 	0,
 	2
 };
@@ -333,6 +336,99 @@ void InitAssembler(void)
 	AsmInsOpcodes[ASMIT_BYTE][ASMIM_ZERO_PAGE] = 0;
 }
 
+struct AsmInsOpcode
+{
+	unsigned char	mOpcode;
+	AsmInsData		mData;
+};
+
+static const AsmInsOpcode CMOSInsData[] = {
+	{ 0x04, { ASMIT_TSB, ASMIM_ZERO_PAGE } },
+	{ 0x0c, { ASMIT_TSB, ASMIM_ABSOLUTE } },
+	{ 0x12, { ASMIT_ORA, ASMIM_ZERO_PAGE_INDIRECT } },
+	{ 0x14, { ASMIT_TRB, ASMIM_ZERO_PAGE } },
+	{ 0x1a, { ASMIT_INC, ASMIM_IMPLIED } },
+	{ 0x1c, { ASMIT_TRB, ASMIM_ABSOLUTE } },
+	{ 0x32, { ASMIT_AND, ASMIM_ZERO_PAGE_INDIRECT } },
+	{ 0x34, { ASMIT_BIT, ASMIM_ZERO_PAGE_X } },
+	{ 0x3a, { ASMIT_DEC, ASMIM_IMPLIED } },
+	{ 0x3c, { ASMIT_BIT, ASMIM_ABSOLUTE_X } },
+	{ 0x52, { ASMIT_EOR, ASMIM_ZERO_PAGE_INDIRECT } },
+	{ 0x5a, { ASMIT_PHY, ASMIM_IMPLIED } },
+	{ 0x64, { ASMIT_STZ, ASMIM_ZERO_PAGE } },
+	{ 0x72, { ASMIT_ADC, ASMIM_ZERO_PAGE_INDIRECT } },
+	{ 0x74, { ASMIT_STZ, ASMIM_ZERO_PAGE_X } },
+	{ 0x7a, { ASMIT_PLY, ASMIM_IMPLIED } },
+	{ 0x80, { ASMIT_BRA, ASMIM_RELATIVE } },
+	{ 0x89, { ASMIT_BIT, ASMIM_IMMEDIATE } },
+	{ 0x92, { ASMIT_STA, ASMIM_ZERO_PAGE_INDIRECT } },
+	{ 0x9c, { ASMIT_STZ, ASMIM_ABSOLUTE } },
+	{ 0x9e, { ASMIT_STZ, ASMIM_ABSOLUTE_X } },
+	{ 0xb2, { ASMIT_LDA, ASMIM_ZERO_PAGE_INDIRECT } },
+	{ 0xd2, { ASMIT_CMP, ASMIM_ZERO_PAGE_INDIRECT } },
+	{ 0xda, { ASMIT_PHX, ASMIM_IMPLIED } },
+	{ 0xf2, { ASMIT_SBC, ASMIM_ZERO_PAGE_INDIRECT } },
+	{ 0xfa, { ASMIT_PLX, ASMIM_IMPLIED } },
+};
+
+static const AsmInsOpcode IllegalInsData[] = {
+	{ 0x83, { ASMIT_SAX, ASMIM_INDIRECT_X } },
+	{ 0x87, { ASMIT_SAX, ASMIM_ZERO_PAGE } },
+	{ 0x8f, { ASMIT_SAX, ASMIM_ABSOLUTE } },
+	{ 0x97, { ASMIT_SAX, ASMIM_ZERO_PAGE_Y } },
+	{ 0xa3, { ASMIT_LAX, ASMIM_INDIRECT_X } },
+	{ 0xa7, { ASMIT_LAX, ASMIM_ZERO_PAGE } },
+	{ 0xaf, { ASMIT_LAX, ASMIM_ABSOLUTE } },
+	{ 0xb3, { ASMIT_LAX, ASMIM_INDIRECT_Y } },
+	{ 0xb7, { ASMIT_LAX, ASMIM_ZERO_PAGE_Y } },
+	{ 0xbf, { ASMIT_LAX, ASMIM_ABSOLUTE_Y } },
+	{ 0xc3, { ASMIT_DCP, ASMIM_INDIRECT_X } },
+	{ 0xc7, { ASMIT_DCP, ASMIM_ZERO_PAGE } },
+	{ 0xcb, { ASMIT_SBX, ASMIM_IMMEDIATE } },
+	{ 0xcf, { ASMIT_DCP, ASMIM_ABSOLUTE } },
+	{ 0xd3, { ASMIT_DCP, ASMIM_INDIRECT_Y } },
+	{ 0xd7, { ASMIT_DCP, ASMIM_ZERO_PAGE_X } },
+	{ 0xdb, { ASMIT_DCP, ASMIM_ABSOLUTE_Y } },
+	{ 0xdf, { ASMIT_DCP, ASMIM_ABSOLUTE_X } },
+	{ 0xe3, { ASMIT_ISC, ASMIM_INDIRECT_X } },
+	{ 0xe7, { ASMIT_ISC, ASMIM_ZERO_PAGE } },
+	{ 0xef, { ASMIT_ISC, ASMIM_ABSOLUTE } },
+	{ 0xf3, { ASMIT_ISC, ASMIM_INDIRECT_Y } },
+	{ 0xf7, { ASMIT_ISC, ASMIM_ZERO_PAGE_X } },
+	{ 0xfb, { ASMIT_ISC, ASMIM_ABSOLUTE_Y } },
+	{ 0xff, { ASMIT_ISC, ASMIM_ABSOLUTE_X } },
+};
+
+static void ExtendAssembler(const AsmInsOpcode* ops, int num)
+{
+	for (int i = 0; i < num; i++)
+	{
+		const AsmInsData& di(ops[i].mData);
+
+		assert(DecInsData[ops[i].mOpcode].mType == ASMIT_INV);
+		assert(AsmInsOpcodes[di.mType][di.mMode] == -1);
+
+		DecInsData[ops[i].mOpcode] = di;
+		AsmInsOpcodes[di.mType][di.mMode] = ops[i].mOpcode;
+	}
+}
+
+void InitAssembler65C02(void)
+{
+	// Extend the decoder and encoder tables with the CMOS opcodes, the
+	// corresponding slots are unused on the NMOS 6502
+
+	ExtendAssembler(CMOSInsData, int(sizeof(CMOSInsData) / sizeof(CMOSInsData[0])));
+}
+
+void InitAssembler6502X(void)
+{
+	// Stable subset of the undocumented NMOS opcodes, these slots are
+	// taken by other instructions on the 65C02
+
+	ExtendAssembler(IllegalInsData, int(sizeof(IllegalInsData) / sizeof(IllegalInsData[0])));
+}
+
 int AsmInsSize(AsmInsType type, AsmInsMode mode)
 {
 	if (type < ASMIT_INV && mode >= ASMIM_IMPLIED && mode < NUM_ASM_INS_MODES)
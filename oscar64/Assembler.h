@@ -8,6 +8,8 @@ enum AsmInsType
 	ASMIT_CLD, ASMIT_CLI, ASMIT_CLV, ASMIT_CMP, ASMIT_CPX, ASMIT_CPY, ASMIT_DEC, ASMIT_DEX, ASMIT_DEY, ASMIT_EOR, ASMIT_INC, ASMIT_INX, ASMIT_INY, ASMIT_JMP,
 	ASMIT_JSR, ASMIT_LDA, ASMIT_LDX, ASMIT_LDY, ASMIT_LSR, ASMIT_NOP, ASMIT_ORA, ASMIT_PHA, ASMIT_PHP, ASMIT_PLA, ASMIT_PLP, ASMIT_ROL, ASMIT_ROR, ASMIT_RTI,
 	ASMIT_RTS, ASMIT_SBC, ASMIT_SEC, ASMIT_SED, ASMIT_SEI, ASMIT_STA, ASMIT_STX, ASMIT_STY, ASMIT_TAX, ASMIT_TAY, ASMIT_TSX, ASMIT_TXA, ASMIT_TXS, ASMIT_TYA,
+	ASMIT_BRA, ASMIT_PHX, ASMIT_PHY, ASMIT_PLX, ASMIT_PLY, ASMIT_STZ, ASMIT_TRB, ASMIT_TSB,
+	ASMIT_DCP, ASMIT_ISC, ASMIT_LAX, ASMIT_SAX, ASMIT_SBX,
 	ASMIT_INV, ASMIT_BYTE,
 
 	NUM_ASM_INS_TYPES
@@ -28,6 +30,7 @@ enum AsmInsMode
 	ASMIM_INDIRECT_X,
 	ASMIM_INDIRECT_Y,
 	ASMIM_RELATIVE,
+	ASMIM_ZERO_PAGE_INDIRECT,
 
 	NUM_ASM_INS_MODES,
 
@@ -58,3 +61,7 @@ bool HasAsmInstructionMode(AsmInsType type, AsmInsMode mode);
 int AsmInsSize(AsmInsType type, AsmInsMode mode);
 
 void InitAssembler(void);
+
+void InitAssembler65C02(void);
+
+void InitAssembler6502X(void);
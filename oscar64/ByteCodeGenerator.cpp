@@ -212,7 +212,7 @@ static ByteCode TransposeBranchCondition(ByteCode code)
 }
 
 ByteCodeInstruction::ByteCodeInstruction(ByteCode code)
-	: mCode(code), mRelocate(false), mRegisterFinal(false), mLinkerObject(nullptr), mValue(0), mRegister(0)
+	: mCode(code), mRelocate(false), mRegisterFinal(false), mLinkerObject(nullptr), mValue(0), mRegister(0), mLive(0)
 {
 }
 
@@ -866,12 +866,17 @@ bool ByteCodeInstruction::ChangesRegister(uint32 reg) const
 			return true;
 		if (mCode == BC_MALLOC || mCode == BC_FREE)
 			return true;
+		// The long forms step the high byte of the pointers page by page
+		if ((mCode == BC_COPY || mCode == BC_FILL) && mValue >= 256)
+			return true;
 	}
 
 	if (reg == BC_REG_ADDR)
 	{
 		if (mCode == BC_ADDR_REG)
 			return true;
+		if ((mCode == BC_COPY || mCode == BC_FILL) && mValue >= 256)
+			return true;
 		if (mCode >= BC_LOAD_ABS_8 && mCode <= BC_STORE_ABS_32)
 			return true;
 		if (mCode == BC_JSR || mCode == BC_CALL_ADDR || mCode == BC_CALL_ABS)
@@ -1335,6 +1340,7 @@ void ByteCodeBasicBlock::PutBytes(const uint8* code, int num)
 
 void ByteCodeBasicBlock::PutCode(ByteCodeGenerator* generator, ByteCode code)
 {
+	mCodeOffsets.Push(mCode.Size());
 	PutByte(uint8(code) * 2);
 	generator->mByteCodeUsed[code]++;
 }
@@ -1356,7 +1362,7 @@ int ByteCodeBasicBlock::PutBranch(ByteCodeGenerator* generator, ByteCode code, i
 }
 
 ByteCodeBasicBlock::ByteCodeBasicBlock(void)
-	: mRelocations({ 0 }), mIns(ByteCodeInstruction(BC_NOP)), mEntryBlocks(nullptr)
+	: mRelocations({ 0 }), mIns(ByteCodeInstruction(BC_NOP)), mEntryBlocks(nullptr), mCodeOffsets(0)
 {
 	mTrueJump = mFalseJump = NULL;
 	mTrueLink = mFalseLink = NULL;
@@ -1364,6 +1370,10 @@ ByteCodeBasicBlock::ByteCodeBasicBlock(void)
 	mPlaced = false;
 	mAssembled = false;
 	mBypassed = false;
+	mLocked = false;
+	mVisited = false;
+	mNeedsNop = false;
+	mNumEntries = 0;
 	mExitLive = 0;
 }
 
@@ -6220,6 +6230,54 @@ void ByteCodeBasicBlock::CopyCode(ByteCodeGenerator* generator, LinkerObject* li
 		mCode.Lookup(i, target[i + mOffset]);
 }
 
+void ByteCodeBasicBlock::CountByteCodePairs(uint32* counts)
+{
+	for (int i = 0; i + 1 < mCodeOffsets.Size(); i++)
+	{
+		uint8	c0, c1;
+		mCode.Lookup(mCodeOffsets[i], c0);
+		mCode.Lookup(mCodeOffsets[i + 1], c1);
+		counts[(c0 / 2) * 128 + c1 / 2]++;
+	}
+}
+
+void ByteCodeBasicBlock::FuseByteCodes(ByteCodeGenerator* generator, ByteCode first, ByteCode second, ByteCode fused)
+{
+	int	i = 0;
+	while (i + 1 < mCodeOffsets.Size())
+	{
+		uint8	c0, c1;
+		mCode.Lookup(mCodeOffsets[i], c0);
+		mCode.Lookup(mCodeOffsets[i + 1], c1);
+
+		if (c0 == first * 2 && c1 == second * 2)
+		{
+			// Replace the first code with the fused code and drop the code byte
+			// of the second, its operands follow the operands of the first
+
+			int	offset = mCodeOffsets[i + 1];
+
+			mCode.Replace(mCodeOffsets[i], uint8(fused * 2), c0);
+			mCode.Remove(offset);
+			mCodeOffsets.Remove(i + 1);
+
+			for (int j = i + 1; j < mCodeOffsets.Size(); j++)
+				mCodeOffsets[j]--;
+			for (int j = 0; j < mRelocations.Size(); j++)
+			{
+				if (mRelocations[j].mOffset > offset)
+					mRelocations[j].mOffset--;
+			}
+
+			generator->mByteCodeUsed[first]--;
+			generator->mByteCodeUsed[second]--;
+			generator->mByteCodeUsed[fused]++;
+		}
+
+		i++;
+	}
+}
+
 void ByteCodeBasicBlock::BuildPlacement(GrowingArray<ByteCodeBasicBlock*>& placement)
 {
 	if (!mPlaced)
@@ -6547,6 +6605,7 @@ ByteCodeProcedure::~ByteCodeProcedure(void)
 void ByteCodeProcedure::Compile(ByteCodeGenerator* generator, InterCodeProcedure* proc)
 {
 	mID = proc->mID;
+	mInterProc = proc;
 
 	mNumBlocks = proc->mNumBlocks;
 
@@ -6627,7 +6686,11 @@ void ByteCodeProcedure::Compile(ByteCodeGenerator* generator, InterCodeProcedure
 		exitBlock->PutWord(uint16(proc->mCommonFrameSize + 2));
 	}
 	exitBlock->PutCode(generator, BC_RETURN); exitBlock->PutByte(tempSave); exitBlock->PutWord(proc->mLocalSize + 2 + tempSave);
+}
 
+void ByteCodeProcedure::Assemble(ByteCodeGenerator* generator)
+{
+	bool	progress;
 
 	ByteCodeBasicBlock* lentryBlock = entryBlock->BypassEmptyBlocks();
 
@@ -6650,10 +6713,10 @@ void ByteCodeProcedure::Compile(ByteCodeGenerator* generator, InterCodeProcedure
 				progress = true;
 	} while (progress);
 
-	uint8* data = proc->mLinkerObject->AddSpace(total);
+	uint8* data = mInterProc->mLinkerObject->AddSpace(total);
 
 	for (int i = 0; i < placement.Size(); i++)
-		placement[i]->CopyCode(generator, proc->mLinkerObject, data);
+		placement[i]->CopyCode(generator, mInterProc->mLinkerObject, data);
 
 	mProgSize = total; 
 }
@@ -6686,8 +6749,13 @@ ByteCodeGenerator::ByteCodeGenerator(Errors* errors, Linker* linker)
 	{
 		mByteCodeUsed[i] = 0;
 		mExtByteCodes[i] = nullptr;
+		mByteCodeHandlers[i] = nullptr;
+		mFusedByteCodes[i] = nullptr;
+		mFusedParts[i] = 1;
 	}
 
+	mStartup = nullptr;
+
 	mByteCodeUsed[BC_CALL_ABS] = 1;
 	mByteCodeUsed[BC_EXIT] = 1;
 	mByteCodeUsed[BC_NATIVE] = 1;
@@ -6706,10 +6774,16 @@ bool ByteCodeGenerator::WriteByteCodeStats(const char* filename)
 	fopen_s(&file, filename, "w");
 	if (file)
 	{
+		setvbuf(file, nullptr, _IOFBF, 0x10000);
 		for (int i = 0; i < 128; i++)
 		{
 			if (mByteCodeUsed[i] > 0)
-				fprintf(file, "BC %s : %d\n", ByteCodeNames[i], mByteCodeUsed[i]);
+			{
+				if (mFusedByteCodes[i])
+					fprintf(file, "BC %s : %d\n", mFusedByteCodes[i]->mIdent->mString, mByteCodeUsed[i]);
+				else
+					fprintf(file, "BC %s : %d\n", ByteCodeNames[i], mByteCodeUsed[i]);
+			}
 		}
 		fclose(file);
 
@@ -6718,3 +6792,306 @@ bool ByteCodeGenerator::WriteByteCodeStats(const char* filename)
 
 	return false;
 }
+
+int ByteCodeGenerator::FirstFusionExits(LinkerObject* obj)
+{
+	// Check if the handler can be the first part of a fused handler.  All
+	// exits have to be direct jumps back into the dispatcher, the handler
+	// must not leave its own code by any other path.  Returns the set of
+	// dispatcher entries used, and the entry of the final jump in the
+	// upper bits.
+
+	int		exits = 0, last = -1, i = 0;
+
+	while (i < obj->mSize)
+	{
+		const AsmInsData& d = DecInsData[obj->mData[i]];
+		if (d.mType == ASMIT_INV)
+			return -1;
+
+		int	n = AsmInsModeSize[d.mMode];
+		if (i + n > obj->mSize)
+			return -1;
+
+		last = -1;
+		switch (d.mType)
+		{
+		case ASMIT_RTS:
+		case ASMIT_RTI:
+		case ASMIT_BRK:
+			return -1;
+		case ASMIT_JMP:
+		{
+			if (d.mMode != ASMIM_ABSOLUTE)
+				return -1;
+
+			LinkerReference* ref = obj->FindReference(i + 1);
+			if (!ref || ref->mOffset != i + 1)
+				return -1;
+
+			if (ref->mRefObject == mStartup)
+			{
+				int k = 0;
+				while (k < 3 && ref->mRefOffset != mExecOffsets[k])
+					k++;
+				if (k == 3)
+					return -1;
+				exits |= 1 << k;
+				last = k;
+			}
+			else if (ref->mRefObject == obj)
+				last = 3;
+			else
+				return -1;
+		}	break;
+		default:
+			if (d.mMode == ASMIM_RELATIVE)
+			{
+				int	t = i + 2 + int8(obj->mData[i + 1]);
+				if (t < 0 || t >= obj->mSize)
+					return -1;
+			}
+		}
+
+		i += n;
+	}
+
+	if (last < 0)
+		return -1;
+	else if (last == 3)
+		return exits;
+	else
+		return exits | ((last + 1) << 4);
+}
+
+bool ByteCodeGenerator::SecondFusionEntry(LinkerObject* obj)
+{
+	// Check if the handler does not depend on the accu and flags left by
+	// the dispatcher, which now hold the result of the first part
+
+	int	i = 0;
+	while (i < obj->mSize)
+	{
+		const AsmInsData& d = DecInsData[obj->mData[i]];
+		switch (d.mType)
+		{
+		case ASMIT_LDA:
+		case ASMIT_LAX:
+		case ASMIT_PLA:
+		case ASMIT_TXA:
+		case ASMIT_TYA:
+			return true;
+		case ASMIT_LDX:
+		case ASMIT_STX:
+		case ASMIT_STY:
+		case ASMIT_INX:
+		case ASMIT_DEX:
+		case ASMIT_INY:
+		case ASMIT_CLC:
+		case ASMIT_SEC:
+		case ASMIT_NOP:
+			i += AsmInsModeSize[d.mMode];
+			break;
+		default:
+			return false;
+		}
+	}
+
+	return false;
+}
+
+LinkerObject* ByteCodeGenerator::FuseHandlers(LinkerObject* first, LinkerObject* second, int exits)
+{
+	// The dispatcher entries used by the first part are appended as a tail
+	// in the order of the dispatcher, falling through into the second part
+
+	int	last = (exits >> 4) - 1;
+	exits &= 7;
+	if (exits & 1)
+		exits |= 2;
+
+	int	asize = first->mSize;
+	if (last >= 0 && !(exits & ((1 << last) - 1)))
+		asize -= 3;
+
+	int	tail[3];
+	int	size = asize;
+	tail[0] = size;
+	if (exits & 1)
+		size += mExecOffsets[1] - mExecOffsets[0];
+	tail[1] = size;
+	if (exits & 2)
+		size++;
+	tail[2] = size;
+
+	char	name[200];
+	sprintf_s(name, "%.90s+%.90s", first->mIdent->mString, second->mIdent->mString);
+
+	LinkerObject* lo = mLinker->AddObject(first->mLocation, Ident::Unique(name), first->mSection, LOT_NATIVE_CODE, first->mAlignment);
+	uint8* d = lo->AddSpace(size + second->mSize);
+
+	memcpy(d, first->mData, asize);
+	if (exits & 1)
+		memcpy(d + tail[0], mStartup->mData + mExecOffsets[0], tail[1] - tail[0]);
+	if (exits & 2)
+		d[tail[1]] = 0xc8;	// iny
+	memcpy(d + size, second->mData, second->mSize);
+
+	lo->mFlags |= (first->mFlags | second->mFlags) & LOBJF_NO_CROSS;
+
+	for (int i = 0; i < first->mReferences.Size(); i++)
+	{
+		LinkerReference	ref = *(first->mReferences[i]);
+		if (ref.mOffset < asize)
+		{
+			ref.mObject = lo;
+			if (ref.mRefObject == first)
+				ref.mRefObject = lo;
+			else if (ref.mRefObject == mStartup && d[ref.mOffset - 1] == 0x4c)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					if (ref.mRefOffset == mExecOffsets[k])
+					{
+						ref.mRefObject = lo;
+						ref.mRefOffset = tail[k];
+					}
+				}
+			}
+			lo->AddReference(ref);
+		}
+	}
+
+	for (int i = 0; i < second->mReferences.Size(); i++)
+	{
+		LinkerReference	ref = *(second->mReferences[i]);
+		ref.mObject = lo;
+		ref.mOffset += size;
+		if (ref.mRefObject == second)
+		{
+			ref.mRefObject = lo;
+			ref.mRefOffset += size;
+		}
+		lo->AddReference(ref);
+	}
+
+	return lo;
+}
+
+void ByteCodeGenerator::BuildSuperInstructions(GrowingArray<ByteCodeProcedure*>& procs, LinkerObject* startup, int tyexec, int yexec, int exec)
+{
+	// Fuse frequent adjacent byte code pairs into new handlers, using the
+	// slots of the byte code table that are not used by this program.  A
+	// fused handler may again be the first or second part of a pair, up to
+	// three byte codes per handler.
+
+	mStartup = startup;
+
+	const uint8* sd = startup->mData;
+	if (!sd || yexec < 0 || exec != yexec + 1 || sd[yexec] != 0xc8)
+		return;
+
+	mExecOffsets[0] = -1;
+	if (tyexec >= 0 && tyexec + 2 == yexec && sd[tyexec] == 0xa4 && !startup->FindReference(tyexec + 1))	// ldy zp
+		mExecOffsets[0] = tyexec;
+	mExecOffsets[1] = yexec;
+	mExecOffsets[2] = exec;
+
+	int		firstExits[128];
+	bool	secondEntry[128], taken[128];
+
+	for (int i = 0; i < 128; i++)
+	{
+		firstExits[i] = -1;
+		secondEntry[i] = false;
+		if (mByteCodeHandlers[i])
+		{
+			firstExits[i] = FirstFusionExits(mByteCodeHandlers[i]);
+			secondEntry[i] = SecondFusionEntry(mByteCodeHandlers[i]);
+		}
+
+		// Branches are only emitted when placing the blocks
+
+		taken[i] = mByteCodeUsed[i] > 0 || i >= BC_JUMPS && i <= BC_BRANCHF_LE;
+	}
+
+	uint32* counts = new uint32[128 * 128];
+
+	int	slot = 0;
+	for (;;)
+	{
+		while (slot < 128 && taken[slot])
+			slot++;
+		if (slot == 128)
+			break;
+
+		memset(counts, 0, 128 * 128 * sizeof(uint32));
+		for (int i = 0; i < procs.Size(); i++)
+		{
+			ByteCodeProcedure* proc = procs[i];
+			for (int j = 0; j < proc->mBlocks.Size(); j++)
+			{
+				if (proc->mBlocks[j]->mAssembled || proc->mBlocks[j] == proc->exitBlock)
+					proc->mBlocks[j]->CountByteCodePairs(counts);
+			}
+		}
+
+		// Each occurrence saves one byte and a dispatch, weigh this against
+		// the size of the new handler
+
+		int	weight = (mLinker->mCompilerOptions & COPT_OPTIMIZE_CODE_SIZE) ? 1 : 4;
+
+		int	best = 0, bfirst = -1, bsecond = -1;
+		for (int i = 0; i < 128; i++)
+		{
+			if (firstExits[i] >= 0)
+			{
+				for (int j = 0; j < 128; j++)
+				{
+					int	c = counts[i * 128 + j];
+					if (c >= 2 && secondEntry[j] && mFusedParts[i] + mFusedParts[j] <= 3)
+					{
+						int	size = mByteCodeHandlers[i]->mSize + mByteCodeHandlers[j]->mSize;
+						int	gain = c * weight - size;
+
+						if (gain > best)
+						{
+							best = gain;
+							bfirst = i;
+							bsecond = j;
+						}
+					}
+				}
+			}
+		}
+
+		if (bfirst < 0)
+			break;
+
+		LinkerObject* lo = FuseHandlers(mByteCodeHandlers[bfirst], mByteCodeHandlers[bsecond], firstExits[bfirst]);
+
+		mFusedByteCodes[slot] = lo;
+		mByteCodeHandlers[slot] = lo;
+		mFusedParts[slot] = mFusedParts[bfirst] + mFusedParts[bsecond];
+		firstExits[slot] = FirstFusionExits(lo);
+		secondEntry[slot] = secondEntry[bfirst];
+		taken[slot] = true;
+
+		mLinker->mByteCodeDisassembler.AddFusedCode(slot, bfirst, bsecond);
+
+		if (mLinker->mCompilerOptions & COPT_VERBOSE2)
+			printf("Fuse byte codes %d <%s> into %d\n", counts[bfirst * 128 + bsecond], lo->mIdent->mString, slot);
+
+		for (int i = 0; i < procs.Size(); i++)
+		{
+			ByteCodeProcedure* proc = procs[i];
+			for (int j = 0; j < proc->mBlocks.Size(); j++)
+			{
+				if (proc->mBlocks[j]->mAssembled || proc->mBlocks[j] == proc->exitBlock)
+					proc->mBlocks[j]->FuseByteCodes(this, ByteCode(bfirst), ByteCode(bsecond), ByteCode(slot));
+			}
+		}
+	}
+
+	delete[] counts;
+}
@@ -253,6 +253,7 @@ public:
 	GrowingArray<ByteCodeInstruction>	mIns;
 	GrowingArray<LinkerReference>	mRelocations;
 	GrowingArray<ByteCodeBasicBlock*>	mEntryBlocks;
+	GrowingArray<int>				mCodeOffsets;
 
 	int						mOffset, mSize, mPlace, mLinear, mNumEntries;
 	bool					mPlaced, mNeedsNop, mBypassed, mAssembled, mVisited, mLocked;
@@ -280,6 +281,9 @@ public:
 
 	void CopyCode(ByteCodeGenerator* generator, LinkerObject * linkerObject, uint8* target);
 
+	void CountByteCodePairs(uint32* counts);
+	void FuseByteCodes(ByteCodeGenerator* generator, ByteCode first, ByteCode second, ByteCode fused);
+
 	void LongConstToAccu(int64 val);
 	void LongConstToWork(int64 val);
 	void IntConstToAccu(int64 val);
@@ -335,8 +339,10 @@ public:
 	GrowingArray < ByteCodeBasicBlock*>	 mBlocks;
 
 	int		mProgSize, mID, mNumBlocks;
+	InterCodeProcedure* mInterProc;
 
 	void Compile(ByteCodeGenerator* generator, InterCodeProcedure* proc);
+	void Assemble(ByteCodeGenerator* generator);
 	ByteCodeBasicBlock * CompileBlock(InterCodeProcedure* iproc, InterCodeBasicBlock* block);
 
 	void ResetVisited(void);
@@ -356,6 +362,18 @@ public:
 
 	uint32	mByteCodeUsed[128];
 	LinkerObject* mExtByteCodes[128];
+	LinkerObject* mByteCodeHandlers[128];
+	LinkerObject* mFusedByteCodes[128];
+	int		mFusedParts[128];
+
+	void BuildSuperInstructions(GrowingArray<ByteCodeProcedure*>& procs, LinkerObject* startup, int tyexec, int yexec, int exec);
 
 	bool WriteByteCodeStats(const char* filename);
+protected:
+	LinkerObject* mStartup;
+	int		mExecOffsets[3];
+
+	int FirstFusionExits(LinkerObject* obj);
+	bool SecondFusionEntry(LinkerObject* obj);
+	LinkerObject* FuseHandlers(LinkerObject* first, LinkerObject* second, int exits);
 };
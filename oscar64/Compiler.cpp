@@ -7,6 +7,7 @@
 #include "NativeCodeGenerator.h"
 #include "Emulator.h"
 #include <stdio.h>
+#include <thread>
 
 Compiler::Compiler(void)
 	: mByteCodeFunctions(nullptr), mCompilerOptions(COPT_DEFAULT), mDefines({nullptr, nullptr})
@@ -36,6 +37,8 @@ Compiler::Compiler(void)
 	mGlobalOptimizer = new GlobalOptimizer(mErrors, mLinker);
 
 	mCartridgeID = 0x0000;
+	mNativeBudget = 0;
+	mOutputFiles = COUT_ALL;
 }
 
 Compiler::~Compiler(void)
@@ -481,6 +484,37 @@ void Compiler::CompileProcedure(InterCodeProcedure* proc)
 	}
 }
 
+LinkerObject* Compiler::ByteCodeHandler(int code, int& offset)
+{
+	offset = 0;
+
+	if (mByteCodeGenerator->mFusedByteCodes[code])
+		return mByteCodeGenerator->mFusedByteCodes[code];
+
+	Declaration* bcdec = mCompilationUnits->mByteCodes[code];
+	if (!bcdec)
+		return nullptr;
+
+	LinkerObject* linkerObject = nullptr;
+	if (bcdec->mType == DT_CONST_ASSEMBLER)
+	{
+		if (!bcdec->mLinkerObject)
+			mInterCodeGenerator->TranslateAssembler(mInterCodeModule, bcdec, nullptr);
+		linkerObject = bcdec->mLinkerObject;
+	}
+	else if (bcdec->mType == DT_LABEL)
+	{
+		if (!bcdec->mBase->mLinkerObject)
+			mInterCodeGenerator->TranslateAssembler(mInterCodeModule, bcdec->mBase, nullptr);
+		linkerObject = bcdec->mBase->mLinkerObject;
+		offset = int(bcdec->mInteger);
+	}
+
+	assert(linkerObject);
+
+	return linkerObject;
+}
+
 bool Compiler::GenerateCode(void)
 {
 	Location	loc;
@@ -883,6 +917,7 @@ bool Compiler::GenerateCode(void)
 	}
 
 	mGlobalAnalyzer->mCompilerOptions = mCompilerOptions;
+	mGlobalAnalyzer->mNativeBudget = (mCompilerOptions & COPT_NATIVE) ? 0 : mNativeBudget;
 
 	if (mCompilerOptions & COPT_VERBOSE)
 		printf("Global analyzer\n");
@@ -979,6 +1014,12 @@ bool Compiler::GenerateCode(void)
 
 		RegisterRuntime(loc, Ident::Unique("malloc"));
 		RegisterRuntime(loc, Ident::Unique("free"));
+		if (mCompilationUnits->mRuntimeScope->Lookup(Ident::Unique("mallocslab0")))
+		{
+			RegisterRuntime(loc, Ident::Unique("mallocslab0"));
+			RegisterRuntime(loc, Ident::Unique("mallocslab1"));
+			RegisterRuntime(loc, Ident::Unique("mallocslab2"));
+		}
 		RegisterRuntime(loc, Ident::Unique("breakpoint"));
 	}
 
@@ -1049,6 +1090,34 @@ bool Compiler::GenerateCode(void)
 		mNativeCodeGenerator->mProcedures[i]->Assemble();
 	}
 
+	if (!(mCompilerOptions & COPT_NATIVE) && (mCompilerOptions & COPT_OPTIMIZE_BYTECODE_FUSION))
+	{
+		if (mCompilerOptions & COPT_VERBOSE)
+			printf("Build byte code super instructions\n");
+
+		for (int i = 0; i < 128; i++)
+		{
+			if (mByteCodeGenerator->mByteCodeUsed[i] > 0)
+			{
+				int	offset;
+				LinkerObject* linkerObject = ByteCodeHandler(i, offset);
+				if (linkerObject && offset == 0)
+					mByteCodeGenerator->mByteCodeHandlers[i] = linkerObject;
+			}
+		}
+
+		DeclarationScope* scope = dcrtstart->mBase->mScope;
+		Declaration* dtyexec = scope->Lookup(Ident::Unique("tyexec"));
+		Declaration* dyexec = scope->Lookup(Ident::Unique("yexec"));
+		Declaration* dexec = scope->Lookup(Ident::Unique("exec"));
+
+		if (dyexec && dexec)
+			mByteCodeGenerator->BuildSuperInstructions(mByteCodeFunctions, dcrtstart->mLinkerObject, dtyexec ? int(dtyexec->mInteger) : -1, int(dyexec->mInteger), int(dexec->mInteger));
+	}
+
+	for (int i = 0; i < mByteCodeFunctions.Size(); i++)
+		mByteCodeFunctions[i]->Assemble(mByteCodeGenerator);
+
 	LinkerObject* byteCodeObject = nullptr;
 	if (!(mCompilerOptions & COPT_NATIVE))
 	{
@@ -1063,28 +1132,10 @@ bool Compiler::GenerateCode(void)
 		{
 			if (mByteCodeGenerator->mByteCodeUsed[i] > 0)
 			{
-				Declaration* bcdec = mCompilationUnits->mByteCodes[i];
-				if (bcdec)
+				int	offset;
+				LinkerObject* linkerObject = ByteCodeHandler(i, offset);
+				if (linkerObject)
 				{
-					LinkerObject* linkerObject = nullptr;
-
-					int	offset = 0;
-					if (bcdec->mType == DT_CONST_ASSEMBLER)
-					{
-						if (!bcdec->mLinkerObject)
-							mInterCodeGenerator->TranslateAssembler(mInterCodeModule, bcdec, nullptr);
-						linkerObject = bcdec->mLinkerObject;
-					}
-					else if (bcdec->mType == DT_LABEL)
-					{
-						if (!bcdec->mBase->mLinkerObject)
-							mInterCodeGenerator->TranslateAssembler(mInterCodeModule, bcdec->mBase, nullptr);
-						linkerObject = bcdec->mBase->mLinkerObject;
-						offset = int(bcdec->mInteger);
-					}
-
-					assert(linkerObject);
-
 					LinkerReference	lref;
 					lref.mObject = byteCodeObject;
 					lref.mFlags = LREF_HIGHBYTE | LREF_LOWBYTE;
@@ -1365,39 +1416,62 @@ bool Compiler::WriteOutputFile(const char* targetPath, DiskImage * d64)
 		mLinker->WritePrgFile(d64, prgPath + i);
 	}
 
-	if (mCompilerOptions & COPT_VERBOSE)
-		printf("Writing <%s>\n", mapPath);
-	mLinker->WriteMapFile(mapPath);
+	// The listings only read the linked program, so they are written
+	// concurrently, each one by its own thread
 
-	if (mCompilerOptions & COPT_VERBOSE)
-		printf("Writing <%s>\n", asmPath);
-	mLinker->WriteAsmFile(asmPath, mVersion);
+	mLinker->BuildAddressTable();
 
-	if (mCompilerOptions & COPT_VERBOSE)
-		printf("Writing <%s>\n", lblPath);
+	std::thread	writers[7];
+	int			nwriters = 0;
 
-	if (mCompilerOptions & COPT_TARGET_NES)
-		mLinker->WriteMlbFile(lblPath, mTargetMachine);
-	else
-		mLinker->WriteLblFile(lblPath);
+	if (mOutputFiles & COUT_MAP)
+	{
+		if (mCompilerOptions & COPT_VERBOSE)
+			printf("Writing <%s>\n", mapPath);
+		writers[nwriters++] = std::thread([this, &mapPath]() { mLinker->WriteMapFile(mapPath); });
+	}
 
-	if (mCompilerOptions & COPT_VERBOSE)
-		printf("Writing <%s>\n", intPath);
-	mInterCodeModule->Disassemble(intPath);
+	if (mOutputFiles & COUT_ASM)
+	{
+		if (mCompilerOptions & COPT_VERBOSE)
+			printf("Writing <%s>\n", asmPath);
+		writers[nwriters++] = std::thread([this, &asmPath]() { mLinker->WriteAsmFile(asmPath, mVersion); });
+	}
+
+	if (mOutputFiles & COUT_LBL)
+	{
+		if (mCompilerOptions & COPT_VERBOSE)
+			printf("Writing <%s>\n", lblPath);
+
+		if (mCompilerOptions & COPT_TARGET_NES)
+			writers[nwriters++] = std::thread([this, &lblPath]() { mLinker->WriteMlbFile(lblPath, mTargetMachine); });
+		else
+			writers[nwriters++] = std::thread([this, &lblPath]() { mLinker->WriteLblFile(lblPath); });
+	}
+
+	if (mOutputFiles & COUT_INT)
+	{
+		if (mCompilerOptions & COPT_VERBOSE)
+			printf("Writing <%s>\n", intPath);
+		writers[nwriters++] = std::thread([this, &intPath]() { mInterCodeModule->Disassemble(intPath); });
+	}
 
-	if (mCompilerOptions & COPT_DEBUGINFO)
-		WriteDbjFile(dbjPath);
+	if ((mOutputFiles & COUT_DBJ) && (mCompilerOptions & COPT_DEBUGINFO))
+		writers[nwriters++] = std::thread([this, &dbjPath]() { WriteDbjFile(dbjPath); });
 
-	if (mCompilerOptions & COPT_PROFILEINFO)
-		WriteCszFile(cszPath);
+	if ((mOutputFiles & COUT_CSZ) && (mCompilerOptions & COPT_PROFILEINFO))
+		writers[nwriters++] = std::thread([this, &cszPath]() { WriteCszFile(cszPath); });
 
-	if (!(mCompilerOptions & COPT_NATIVE))
+	if ((mOutputFiles & COUT_BCS) && !(mCompilerOptions & COPT_NATIVE))
 	{
 		if (mCompilerOptions & COPT_VERBOSE)
 			printf("Writing <%s>\n", bcsPath);
-		mByteCodeGenerator->WriteByteCodeStats(bcsPath);
+		writers[nwriters++] = std::thread([this, &bcsPath]() { mByteCodeGenerator->WriteByteCodeStats(bcsPath); });
 	}
 
+	for (int i = 0; i < nwriters; i++)
+		writers[i].join();
+
 	return true;
 }
 
@@ -1463,6 +1537,7 @@ bool Compiler::WriteCszFile(const char* filename)
 	fopen_s(&file, filename, "wb");
 	if (file)
 	{
+		setvbuf(file, nullptr, _IOFBF, 0x10000);
 		for (int i = 0; i < mInterCodeModule->mProcedures.Size(); i++)
 		{
 			InterCodeProcedure* p(mInterCodeModule->mProcedures[i]);
@@ -1568,6 +1643,7 @@ bool Compiler::WriteDbjFile(const char* filename)
 	fopen_s(&file, filename, "wb");
 	if (file)
 	{
+		setvbuf(file, nullptr, _IOFBF, 0x10000);
 		fprintf(file, "{");
 		mLinker->WriteDbjFile(file);
 		fprintf(file, ",\n");
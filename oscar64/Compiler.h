@@ -33,6 +33,8 @@ public:
 	TargetMachine	mTargetMachine;
 	uint64			mCompilerOptions;
 	uint16			mCartridgeID;
+	int				mNativeBudget;
+	uint32			mOutputFiles;
 	char			mVersion[32];
 
 	struct Define
@@ -54,6 +56,7 @@ public:
 	void AddDefine(const Ident* ident, const char* value);
 
 	void RegisterRuntime(const Location& loc, const Ident* ident);
+	LinkerObject* ByteCodeHandler(int code, int& offset);
 
 	void CompileProcedure(InterCodeProcedure* proc);
 	void BuildVTables(void);
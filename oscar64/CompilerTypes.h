@@ -15,10 +15,15 @@ static const uint64 COPT_OPTIMIZE_CONST_PARAMS = 1ULL << 9;
 static const uint64 COPT_OPTIMIZE_MERGE_CALLS = 1ULL << 10;
 static const uint64 COPT_OPTIMIZE_GLOBAL = 1ULL << 11;
 static const uint64 COPT_OPTIMIZE_OUTLINE = 1ULL << 12;
+static const uint64 COPT_OPTIMIZE_SELF_MODIFY = 1ULL << 13;
+static const uint64 COPT_OPTIMIZE_BYTECODE_FUSION = 1ULL << 14;
 
 static const uint64 COPT_OPTIMIZE_CODE_SIZE = 1ULL << 16;
 static const uint64 COPT_NATIVE = 1ULL << 17;
+static const uint64 COPT_BANK_TRAMPOLINES = 1ULL << 18;
 static const uint64 COPT_EXTENDED_ZERO_PAGE = 1ULL << 20;
+static const uint64 COPT_CPU_65C02 = 1ULL << 21;
+static const uint64 COPT_CPU_6502X = 1ULL << 22;
 
 static const uint64 COPT_TARGET_PRG = 1ULL << 32;
 static const uint64 COPT_TARGET_CRT8 = 1ULL << 33;
@@ -57,6 +62,16 @@ static const uint64 COPT_OPTIMIZE_SPEED = COPT_OPTIMIZE_BASIC | COPT_OPTIMIZE_IN
 
 static const uint64 COPT_OPTIMIZE_ALL = COPT_OPTIMIZE_BASIC | COPT_OPTIMIZE_INLINE | COPT_OPTIMIZE_AUTO_INLINE | COPT_OPTIMIZE_AUTO_INLINE_ALL | COPT_OPTIMIZE_AUTO_UNROLL | COPT_OPTIMIZE_CONST_EXPRESSIONS | COPT_OPTIMIZE_ASSEMBLER | COPT_OPTIMIZE_AUTO_ZEROPAGE | COPT_OPTIMIZE_CONST_PARAMS | COPT_OPTIMIZE_MERGE_CALLS | COPT_OPTIMIZE_GLOBAL;
 
+static const uint32 COUT_MAP = 1 << 0;
+static const uint32 COUT_ASM = 1 << 1;
+static const uint32 COUT_LBL = 1 << 2;
+static const uint32 COUT_INT = 1 << 3;
+static const uint32 COUT_BCS = 1 << 4;
+static const uint32 COUT_DBJ = 1 << 5;
+static const uint32 COUT_CSZ = 1 << 6;
+
+static const uint32 COUT_ALL = COUT_MAP | COUT_ASM | COUT_LBL | COUT_INT | COUT_BCS | COUT_DBJ | COUT_CSZ;
+
 enum TargetMachine
 {
 	TMACH_C64,
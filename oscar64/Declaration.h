@@ -127,6 +127,7 @@ static const uint64 DTF_FPARAM_UNUSED	= (1ULL << 49);
 static const uint64 DTF_DEPRECATED		= (1ULL << 50);
 static const uint64 DTF_FUNC_NO_RETURN	= (1ULL << 51);
 static const uint64 DTF_PLACED			= (1ULL << 52);
+static const uint64 DTF_FUNC_ASMCALLED	= (1ULL << 53);
 
 
 
@@ -295,7 +296,7 @@ public:
 
 	Expression*			mValue, * mReturn;
 	DeclarationScope*	mScope;
-	int					mOffset, mSize, mVarIndex, mNumVars, mComplexity, mLocalSize, mAlignment, mFastCallBase, mFastCallSize, mStride, mStripe;
+	int					mOffset, mSize, mVarIndex, mNumVars, mComplexity, mWeightedComplexity, mLocalSize, mAlignment, mFastCallBase, mFastCallSize, mStride, mStripe;
 	uint8				mShift, mBits;
 	int64				mInteger, mMinValue, mMaxValue;
 	double				mNumber;
@@ -6,7 +6,8 @@
 
 ByteCodeDisassembler::ByteCodeDisassembler(void)
 {
-
+	for (int i = 0; i < 128; i++)
+		mFusedCodes[i][0] = mFusedCodes[i][1] = -1;
 }
 
 ByteCodeDisassembler::~ByteCodeDisassembler(void)
@@ -14,6 +15,26 @@ ByteCodeDisassembler::~ByteCodeDisassembler(void)
 
 }
 
+void ByteCodeDisassembler::AddFusedCode(int code, int first, int second)
+{
+	mFusedCodes[code][0] = first;
+	mFusedCodes[code][1] = second;
+}
+
+int ByteCodeDisassembler::ExpandCode(int code, int* codes, int n)
+{
+	// Push the parts of a fused byte code in reverse order
+
+	if (mFusedCodes[code][0] >= 0)
+	{
+		n = ExpandCode(mFusedCodes[code][1], codes, n);
+		return ExpandCode(mFusedCodes[code][0], codes, n);
+	}
+
+	codes[n] = code;
+	return n + 1;
+}
+
 const char* ByteCodeDisassembler::TempName(uint8 tmp, char* buffer, InterCodeProcedure* proc, Linker* linker)
 {
 	if (tmp == BC_REG_ADDR)
@@ -82,15 +103,21 @@ void ByteCodeDisassembler::Disassemble(FILE* file, const uint8* memory, int bank
 		printf("T%d = $%.2x\n", i, BC_REG_TMP + proc->mTempOffset[i]);
 #endif
 	int	i = 0;
+	int	codes[16], ncodes = 0;
 	while (i < size)
 	{
-		ByteCode	bc = ByteCode(memory[start + i] / 2);
-
 		if (bank >= 0)
 			fprintf(file, "%02x:", bank);
 
 		fprintf(file, "%04x:\t", start + i);
-		i++;
+
+		if (!ncodes)
+		{
+			ncodes = ExpandCode(memory[start + i] / 2, codes, 0);
+			i++;
+		}
+
+		ByteCode	bc = ByteCode(codes[--ncodes]);
 
 		switch (bc)
 		{
@@ -777,6 +804,10 @@ void NativeCodeDisassembler::Disassemble(FILE* file, const uint8* memory, int ba
 			addr = memory[ip++];
 			fprintf(file, "%04x : %02x %02x __ %s (%s),y %s\n", iip, memory[iip], memory[iip + 1], AsmInstructionNames[d.mType], TempName(addr, tbuffer, proc, linker), AddrName(bank, addr, abuffer, proc, linker));
 			break;
+		case ASMIM_ZERO_PAGE_INDIRECT:
+			addr = memory[ip++];
+			fprintf(file, "%04x : %02x %02x __ %s (%s) %s\n", iip, memory[iip], memory[iip + 1], AsmInstructionNames[d.mType], TempName(addr, tbuffer, proc, linker), AddrName(bank, addr, abuffer, proc, linker));
+			break;
 		case ASMIM_RELATIVE:
 			addr = memory[ip++];
 			if (addr & 0x80)
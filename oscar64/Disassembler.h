@@ -16,9 +16,14 @@ public:
 	~ByteCodeDisassembler(void);
 
 	void Disassemble(FILE* file, const uint8* memory, int bank, int start, int size, InterCodeProcedure* proc, const Ident* ident, Linker * linker);
+
+	void AddFusedCode(int code, int first, int second);
 protected:
+	int	mFusedCodes[128][2];
+
 	const char* TempName(uint8 tmp, char* buffer, InterCodeProcedure* proc, Linker* linker);
 	const char* AddrName(int addr, char* buffer, Linker* linker);
+	int ExpandCode(int code, int * codes, int n);
 };
 
 class NativeCodeDisassembler
@@ -0,0 +1,276 @@
+#pragma once
+
+#include "Array.h"
+
+// Dominator tree and loop nesting forest of a control flow graph, where each
+// block has up to two successors mTrueJump and mFalseJump.
+//
+// The reachable blocks are numbered in reverse post order of a depth first
+// walk from the entry block, the immediate dominators are computed with the
+// iterative algorithm of Cooper, Harvey and Kennedy.  Build stores the result
+// in the blocks:
+//
+//	mDominator		immediate dominator, nullptr for the entry block
+//	mDomNum			preorder number in the dominator tree
+//	mDomEnd			one past the last preorder number of the dominated subtree
+//
+// so a block dominates another one if the mDomNum of the other block is inside
+// its [mDomNum, mDomEnd) interval.  Build uses the mVisited flags of the blocks,
+// which must be reset by the caller.  Unreachable blocks are not touched, the
+// caller has to reset their mDominator and set their mDomNum to -1.
+
+template <class T>
+class DominatorTree
+{
+public:
+	ExpandingArray<T*>		mOrder;						// Reachable blocks in reverse post order
+	ExpandingArray<int>		mSucc;						// Successor of edge 2 * block + (0 for true, 1 for false), -1 if none
+	ExpandingArray<int>		mPredStart, mPredEdges;		// Incoming edges of each block
+	ExpandingArray<int>		mIDom;						// Immediate dominator, the entry block dominates itself
+	ExpandingArray<int>		mDomStart, mDomChildren;	// Children in the dominator tree
+	ExpandingArray<int>		mLoop;						// Header of the innermost natural loop containing a block, or -1
+	ExpandingArray<int>		mLoopParent;				// Header of the loop enclosing the loop of a header, or -1
+	ExpandingArray<int>		mLoopDepth;					// Number of natural loops containing a block
+
+	int Size(void) const
+	{
+		return mOrder.Size();
+	}
+
+	int Successor(int block, int edge) const
+	{
+		return mSucc[2 * block + edge];
+	}
+
+	bool Dominates(int b1, int b2) const
+	{
+		const T* d1 = mOrder[b1], * d2 = mOrder[b2];
+		return d1->mDomNum <= d2->mDomNum && d2->mDomNum < d1->mDomEnd;
+	}
+
+	void Build(T* entry)
+	{
+		// Depth first walk, the post order number is kept in mDomNum until
+		// the dominator tree is numbered
+
+		ExpandingArray<T*>	stack;
+		ExpandingArray<int>	next;
+		int					n = 0;
+
+		mOrder.SetSize(0);
+
+		entry->mVisited = true;
+		stack.Push(entry);
+		next.Push(0);
+		while (stack.Size() > 0)
+		{
+			T* block = stack.Last();
+			int	k = next.Last();
+			if (k < 2)
+			{
+				next[next.Size() - 1]++;
+				T* succ = k ? block->mFalseJump : block->mTrueJump;
+				if (succ && !succ->mVisited)
+				{
+					succ->mVisited = true;
+					stack.Push(succ);
+					next.Push(0);
+				}
+			}
+			else
+			{
+				block->mDomNum = n++;
+				mOrder.Push(block);
+				stack.Pop();
+				next.Pop();
+			}
+		}
+
+		for (int i = 0; i < n / 2; i++)
+		{
+			T* b = mOrder[i];
+			mOrder[i] = mOrder[n - 1 - i];
+			mOrder[n - 1 - i] = b;
+		}
+
+		mSucc.SetSize(2 * n);
+		for (int i = 0; i < n; i++)
+		{
+			T* block = mOrder[i];
+			mSucc[2 * i + 0] = block->mTrueJump ? n - 1 - block->mTrueJump->mDomNum : -1;
+			mSucc[2 * i + 1] = block->mFalseJump ? n - 1 - block->mFalseJump->mDomNum : -1;
+		}
+
+		// Incoming edges
+
+		ExpandingArray<int>	fill;
+
+		mPredStart.SetSize(n + 1);
+		for (int i = 0; i <= n; i++)
+			mPredStart[i] = 0;
+		for (int i = 0; i < 2 * n; i++)
+		{
+			if (mSucc[i] >= 0)
+				mPredStart[mSucc[i] + 1]++;
+		}
+		for (int i = 0; i < n; i++)
+			mPredStart[i + 1] += mPredStart[i];
+
+		fill.SetSize(n);
+		for (int i = 0; i < n; i++)
+			fill[i] = mPredStart[i];
+		mPredEdges.SetSize(mPredStart[n]);
+		for (int i = 0; i < 2 * n; i++)
+		{
+			if (mSucc[i] >= 0)
+				mPredEdges[fill[mSucc[i]]++] = i;
+		}
+
+		// Immediate dominators
+
+		mIDom.SetSize(n);
+		for (int i = 0; i < n; i++)
+			mIDom[i] = -1;
+		mIDom[0] = 0;
+
+		bool	changed;
+		do {
+			changed = false;
+			for (int i = 1; i < n; i++)
+			{
+				int	dom = -1;
+				for (int j = mPredStart[i]; j < mPredStart[i + 1]; j++)
+				{
+					int	p = mPredEdges[j] >> 1;
+					if (mIDom[p] >= 0)
+						dom = dom < 0 ? p : Intersect(p, dom);
+				}
+				if (dom != mIDom[i])
+				{
+					mIDom[i] = dom;
+					changed = true;
+				}
+			}
+		} while (changed);
+
+		mDomStart.SetSize(n + 1);
+		for (int i = 0; i <= n; i++)
+			mDomStart[i] = 0;
+		for (int i = 1; i < n; i++)
+			mDomStart[mIDom[i] + 1]++;
+		for (int i = 0; i < n; i++)
+			mDomStart[i + 1] += mDomStart[i];
+
+		for (int i = 0; i < n; i++)
+			fill[i] = mDomStart[i];
+		mDomChildren.SetSize(mDomStart[n]);
+		for (int i = 1; i < n; i++)
+			mDomChildren[fill[mIDom[i]]++] = i;
+
+		// Preorder intervals of the dominator tree
+
+		ExpandingArray<int>	dstack;
+		int					num = 0;
+
+		entry->mDominator = nullptr;
+		entry->mDomNum = num++;
+		dstack.Push(0);
+		for (int i = 0; i < n; i++)
+			fill[i] = mDomStart[i];
+		while (dstack.Size() > 0)
+		{
+			int	b = dstack.Last();
+			if (fill[b] < mDomStart[b + 1])
+			{
+				int	c = mDomChildren[fill[b]++];
+				mOrder[c]->mDominator = mOrder[b];
+				mOrder[c]->mDomNum = num++;
+				dstack.Push(c);
+			}
+			else
+			{
+				mOrder[b]->mDomEnd = num;
+				dstack.Pop();
+			}
+		}
+
+		// Loop nesting forest, headers are processed inner to outer, a header
+		// has a larger number than the headers of all enclosing loops
+
+		ExpandingArray<int>	work;
+
+		mLoop.SetSize(n);
+		mLoopParent.SetSize(n);
+		mLoopDepth.SetSize(n);
+		for (int i = 0; i < n; i++)
+		{
+			mLoop[i] = -1;
+			mLoopParent[i] = -1;
+		}
+
+		for (int h = n - 1; h >= 0; h--)
+		{
+			for (int j = mPredStart[h]; j < mPredStart[h + 1]; j++)
+			{
+				int	p = mPredEdges[j] >> 1;
+				if (Dominates(h, p))
+				{
+					mLoop[h] = h;
+					work.Push(p);
+				}
+			}
+
+			while (work.Size() > 0)
+			{
+				int	r = LoopRoot(work.Pop());
+				if (r != h && Dominates(h, r))
+				{
+					if (mLoop[r] < 0)
+						mLoop[r] = h;
+					else
+						mLoopParent[r] = h;
+
+					for (int j = mPredStart[r]; j < mPredStart[r + 1]; j++)
+						work.Push(mPredEdges[j] >> 1);
+				}
+			}
+		}
+
+		for (int i = 0; i < n; i++)
+		{
+			if (mLoop[i] == i)
+				mLoopDepth[i] = (mLoopParent[i] >= 0 ? mLoopDepth[mLoopParent[i]] : 0) + 1;
+			else if (mLoop[i] >= 0)
+				mLoopDepth[i] = mLoopDepth[mLoop[i]];
+			else
+				mLoopDepth[i] = 0;
+		}
+	}
+
+protected:
+	int Intersect(int b1, int b2) const
+	{
+		while (b1 != b2)
+		{
+			while (b1 > b2)
+				b1 = mIDom[b1];
+			while (b2 > b1)
+				b2 = mIDom[b2];
+		}
+		return b1;
+	}
+
+	// Outermost loop found so far that contains the block
+
+	int LoopRoot(int block) const
+	{
+		while (mLoop[block] >= 0)
+		{
+			int	h = mLoop[block] == block ? mLoopParent[block] : mLoop[block];
+			if (h < 0)
+				break;
+			block = h;
+		}
+		return block;
+	}
+};
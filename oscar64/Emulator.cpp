@@ -181,6 +181,12 @@ bool Emulator::EmulateInstruction(AsmInsType type, AsmInsMode mode, int addr, in
 		}
 		break;
 	case ASMIT_BIT:
+		if (mode == ASMIM_IMMEDIATE)
+		{
+			mRegP &= ~STATUS_ZERO;
+			if (!(addr & mRegA)) mRegP |= STATUS_ZERO;
+			break;
+		}
 		t = mMemory[addr];
 		mRegP &= ~(STATUS_ZERO | STATUS_SIGN | STATUS_OVERFLOW);
 		if (t & 0x80) mRegP |= STATUS_SIGN;
@@ -509,6 +515,87 @@ bool Emulator::EmulateInstruction(AsmInsType type, AsmInsMode mode, int addr, in
 		mRegA = mRegY;
 		UpdateStatus(mRegA);
 		break;
+	case ASMIT_BRA:
+		mIP = addr;
+		cycles++;
+		break;
+	case ASMIT_PHX:
+		mMemory[0x100 + mRegS] = mRegX;
+		mRegS--;
+		cycles++;
+		break;
+	case ASMIT_PHY:
+		mMemory[0x100 + mRegS] = mRegY;
+		mRegS--;
+		cycles++;
+		break;
+	case ASMIT_PLX:
+		mRegS++;
+		mRegX = mMemory[0x100 + mRegS];
+		UpdateStatus(mRegX);
+		cycles++;
+		break;
+	case ASMIT_PLY:
+		mRegS++;
+		mRegY = mMemory[0x100 + mRegS];
+		UpdateStatus(mRegY);
+		cycles++;
+		break;
+	case ASMIT_STZ:
+		mMemory[addr] = 0;
+		if (indexed) cycles++;
+		break;
+	case ASMIT_TRB:
+		t = mMemory[addr];
+		mRegP &= ~STATUS_ZERO;
+		if (!(t & mRegA)) mRegP |= STATUS_ZERO;
+		mMemory[addr] = t & ~mRegA;
+		cycles += 2;
+		break;
+	case ASMIT_TSB:
+		t = mMemory[addr];
+		mRegP &= ~STATUS_ZERO;
+		if (!(t & mRegA)) mRegP |= STATUS_ZERO;
+		mMemory[addr] = t | mRegA;
+		cycles += 2;
+		break;
+	case ASMIT_LAX:
+		mRegA = mRegX = mMemory[addr];
+		UpdateStatus(mRegA);
+		if (cross) cycles++;
+		break;
+	case ASMIT_SAX:
+		mMemory[addr] = mRegA & mRegX;
+		break;
+	case ASMIT_DCP:
+		t = (mMemory[addr] - 1) & 255;
+		mMemory[addr] = t;
+		t = mRegA + (t ^ 0xff) + 1;
+		UpdateStatusCarry(t & 255, t >= 256);
+		cycles += 2;
+		if (indexed) cycles++;
+		break;
+	case ASMIT_ISC:
+		mMemory[addr] = (mMemory[addr] + 1) & 255;
+		addr = mMemory[addr];
+		t = mRegA + (addr ^ 0xff) + (mRegP & STATUS_CARRY);
+
+		mRegP = 0;
+
+		if ((mRegA & 0x80) && !(addr & 0x80) && !(t & 0x80) ||
+			!(mRegA & 0x80) && (addr & 0x80) && (t & 0x80))
+			mRegP |= STATUS_OVERFLOW;
+
+		mRegA = (t & 255);
+		UpdateStatusCarry(t & 255, t >= 256);
+		cycles += 2;
+		if (indexed) cycles++;
+		break;
+	case ASMIT_SBX:
+		t = (mRegA & mRegX) + (addr ^ 0xff) + 1;
+		mRegX = (t & 255);
+		UpdateStatusCarry(mRegX, t >= 256);
+		break;
 	case ASMIT_INV:
 		return false;
 		break;
@@ -677,6 +764,13 @@ int Emulator::Emulate(int startIP, int trace)
 					printf("%04x : %04x %02x %02x __ %s ($%02x),y (A:%02x X:%02x Y:%02x P:%02x S:%02x %04x M:%02x)\n", iip, ip, mMemory[ip], mMemory[ip + 1], AsmInstructionNames[d.mType], taddr, mRegA, mRegX, mRegY, mRegP, mRegS, addr, mMemory[addr]);
 				icycles = 5;
 				break;
+			case ASMIM_ZERO_PAGE_INDIRECT:
+				taddr = mMemory[mIP++];
+				addr = mMemory[taddr] + 256 * mMemory[(taddr + 1) & 0xff];
+				if (trace & 2)
+					printf("%04x : %04x %02x %02x __ %s ($%02x)   (A:%02x X:%02x Y:%02x P:%02x S:%02x %04x M:%02x)\n", iip, ip, mMemory[ip], mMemory[ip + 1], AsmInstructionNames[d.mType], taddr, mRegA, mRegX, mRegY, mRegP, mRegS, addr, mMemory[addr]);
+				icycles = 5;
+				break;
 			case ASMIM_RELATIVE:
 				taddr = mMemory[mIP++];
 				if (taddr & 0x80)
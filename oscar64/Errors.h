@@ -119,6 +119,8 @@ enum ErrorID
 	EERR_INVALID_PREPROCESSOR,
 	EERR_INVALID_CLASS_INITIALIZER,
 	EERR_CALL_OF_DELETED_FUNCTION,
+	ERRR_SELF_MODIFYING_CODE_IN_ROM,
+	ERRR_CROSS_BANK_CALL,
 
 	EFATAL_GENERIC = 4000,
 	EFATAL_OUT_OF_MEMORY,
@@ -1,7 +1,8 @@
 #include "GlobalAnalyzer.h"
 
 GlobalAnalyzer::GlobalAnalyzer(Errors* errors, Linker* linker)
-	: mErrors(errors), mLinker(linker), mCalledFunctions(nullptr), mCallingFunctions(nullptr), mVariableFunctions(nullptr), mFunctions(nullptr), mGlobalVariables(nullptr), mTopoFunctions(nullptr), mCompilerOptions(COPT_DEFAULT)
+	: mErrors(errors), mLinker(linker), mCalledFunctions(nullptr), mCallingFunctions(nullptr), mVariableFunctions(nullptr), mFunctions(nullptr), mGlobalVariables(nullptr), mTopoFunctions(nullptr), 
+	mCallSiteFrom(nullptr), mCallSiteTo(nullptr), mCallSiteWeight(0), mCompilerOptions(COPT_DEFAULT), mNativeBudget(0), mLoopDepth(0)
 {
 
 }
@@ -58,37 +59,43 @@ void GlobalAnalyzer::DumpCallGraph(void)
 	}
 }
 
-static int VarUseCountScale(Declaration* type)
+// Cycles saved per access, when a variable of this type is placed in zero page
+
+static int ZeroPageAccessGain(Declaration* type)
 {
 	if (type->mType == DT_TYPE_BOOL || type->mType == DT_TYPE_INTEGER || type->mType == DT_TYPE_FLOAT || type->mType == DT_TYPE_ENUM)
-		return 0x100 / type->mSize;
+		return type->mSize;
 	else if (type->mType == DT_TYPE_POINTER)
-		return 0x800;
-	else if (type->mType == DT_TYPE_ARRAY)
-	{
-		if (type->mSize > 0)
-			return VarUseCountScale(type->mBase) / type->mSize;
-		else
-			return 0;
-	}
-	else if (type->mSize == DT_TYPE_STRUCT)
-	{
-		int size = 0;
-		Declaration* e = type->mParams;
-		while (e)
-		{
-			int t = VarUseCountScale(e->mBase);
-			if (t == 0)
-				return 0;
-			size += t;
-			e = e->mNext;
-		}
-		return size / (type->mSize * type->mSize);
-	}
+		return 2;
+	else if (type->mType == DT_TYPE_ARRAY && type->mSize > 0)
+		return ZeroPageAccessGain(type->mBase);
 	else
 		return 0;
 }
 
+// Extra cycles saved, when a pointer in zero page is dereferenced directly
+// instead of being copied into a zero page temporary first
+
+static const int ZeroPageDerefGain = 10;
+
+int GlobalAnalyzer::AccessWeight(void) const
+{
+	return 1 << (2 * (mLoopDepth < 4 ? mLoopDepth : 4));
+}
+
+void GlobalAnalyzer::AddLoopComplexity(Declaration* procDec, int complexity)
+{
+	// Each loop level weights its body by four, matching AccessWeight
+	if (mLoopDepth < 4)
+		procDec->mWeightedComplexity += 3 * AccessWeight() * (procDec->mComplexity - complexity);
+}
+
+void GlobalAnalyzer::AddPointerDeref(Declaration* dec)
+{
+	if (dec->mType == DT_VARIABLE && (dec->mFlags & (DTF_GLOBAL | DTF_STATIC)) && dec->mBase->mType == DT_TYPE_POINTER)
+		dec->mUseCount += AccessWeight() * ZeroPageDerefGain;
+}
+
 void GlobalAnalyzer::AutoZeroPage(LinkerSection* lszp, int zpsize)
 {
 	if (mCompilerOptions & COPT_OPTIMIZE_AUTO_ZEROPAGE)
@@ -102,32 +109,67 @@ void GlobalAnalyzer::AutoZeroPage(LinkerSection* lszp, int zpsize)
 			{
 				if (var->mFlags & DTF_ZEROPAGE)
 					zpsize -= var->mSize;
-				else if (var->mValue)
-					;
-				else
+			}
+		}
+
+		for (int i = 0; i < mGlobalVariables.Size(); i++)
+		{
+			Declaration* var = mGlobalVariables[i];
+			if ((var->mFlags & DTF_ANALYZED) && !(var->mFlags & DTF_ZEROPAGE) && !var->mValue && !var->mLinkerObject)
+			{
+				if (var->mUseCount > 0 && ZeroPageAccessGain(var->mBase) > 0 && var->mSize > 0 && var->mSize <= zpsize)
+					vars.Push(var);
+			}
+		}
+
+		if (vars.Size() > 0)
+		{
+			// Knapsack over the available zero page bytes, with the loop
+			// weighted cycle gain of each variable as its value
+
+			int		n = vars.Size();
+			int	*	gain = new int[zpsize + 1];
+			bool*	take = new bool[n * (zpsize + 1)];
+
+			for (int j = 0; j <= zpsize; j++)
+				gain[j] = 0;
+
+			for (int i = 0; i < n; i++)
+			{
+				Declaration* var = vars[i];
+				bool* vtake = take + i * (zpsize + 1);
+
+				for (int j = zpsize; j >= 0; j--)
 				{
-					var->mUseCount *= VarUseCountScale(var->mBase);
-					if (var->mUseCount)
+					vtake[j] = false;
+					if (j >= var->mSize && gain[j - var->mSize] + var->mUseCount > gain[j])
 					{
-						int j = 0;
-						while (j < vars.Size() && vars[j]->mUseCount > var->mUseCount)
-							j++;
-						vars.Insert(j, var);
+						gain[j] = gain[j - var->mSize] + var->mUseCount;
+						vtake[j] = true;
 					}
 				}
 			}
-		}
 
-		int i = 0;
-		while (i < vars.Size() && zpsize > 0)
-		{
-			if (vars[i]->mSize <= zpsize && !vars[i]->mLinkerObject)
+			int	j = zpsize, total = gain[zpsize];
+			for (int i = n - 1; i >= 0; i--)
 			{
-				vars[i]->mSection = lszp;
-				vars[i]->mFlags |= DTF_ZEROPAGE;
-				zpsize -= vars[i]->mSize;
+				Declaration* var = vars[i];
+				if (take[i * (zpsize + 1) + j])
+				{
+					var->mSection = lszp;
+					var->mFlags |= DTF_ZEROPAGE;
+					j -= var->mSize;
+
+					if (mCompilerOptions & COPT_VERBOSE2)
+						printf("Zero page %s[%d] saves %d cycles\n", var->mQualIdent->mString, var->mSize, var->mUseCount);
+				}
 			}
-			i++;
+
+			if (mCompilerOptions & COPT_VERBOSE2)
+				printf("Zero page %d bytes saves %d cycles\n", zpsize - j, total);
+
+			delete[] take;
+			delete[] gain;
 		}
 	}
 }
@@ -265,6 +307,9 @@ void GlobalAnalyzer::AutoInline(void)
 
 	} while (changed);
 
+	if (mNativeBudget > 0)
+		AutoNative();
+
 	for (int i = 0; i < mFunctions.Size(); i++)
 	{
 		CheckFastcall(mFunctions[i], true);
@@ -305,6 +350,141 @@ void GlobalAnalyzer::AutoInline(void)
 
 }
 
+int GlobalAnalyzer::NativeCodeGrowth(Declaration* procDec) const
+{
+	// Estimated from the complexity, native code is about a quarter
+	// larger than byte code, which needs roughly a byte per four units
+	int	growth = procDec->mComplexity / 16;
+	return growth > 0 ? growth : 1;
+}
+
+void GlobalAnalyzer::AutoNative(void)
+{
+	int		n = mTopoFunctions.Size();
+
+	// Estimate the number of invocations of each function from the loop
+	// depth of its call sites, callers are sorted behind their callees
+
+	GrowingArray<int64>	invokes(0), heat(0);
+
+	for (int i = 0; i < n; i++)
+		invokes[i] = mTopoFunctions[i]->mCallers.Size() == 0 ? 1 : 0;
+
+	for (int i = n - 1; i >= 0; i--)
+	{
+		Declaration* f = mTopoFunctions[i];
+		if (invokes[i] > 0x100000)
+			invokes[i] = 0x100000;
+
+		for (int j = 0; j < mCallSiteFrom.Size(); j++)
+		{
+			if (mCallSiteFrom[j] == f)
+			{
+				Declaration* to = mCallSiteTo[j];
+				if (to->mType == DT_CONST_FUNCTION)
+				{
+					int k = mTopoFunctions.IndexOf(to);
+					if (k >= 0)
+						invokes[k] += invokes[i] * mCallSiteWeight[j];
+				}
+				else
+				{
+					for (int k = 0; k < mVariableFunctions.Size(); k++)
+					{
+						Declaration* vf = mVariableFunctions[k];
+						if (vf->mBase->IsSame(to))
+						{
+							int m = mTopoFunctions.IndexOf(vf);
+							if (m >= 0)
+								invokes[m] += invokes[i] * mCallSiteWeight[j];
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// The run time of an inlined function adds to its callers
+
+	for (int i = 0; i < n; i++)
+	{
+		Declaration* f = mTopoFunctions[i];
+
+		heat[i] = f->mWeightedComplexity;
+		for (int j = 0; j < mCallSiteFrom.Size(); j++)
+		{
+			Declaration* to = mCallSiteTo[j];
+			if (mCallSiteFrom[j] == f && to->mType == DT_CONST_FUNCTION && (to->mFlags & DTF_INLINE) && ((f->mFlags & DTF_NATIVE) || !(to->mFlags & DTF_NATIVE)))
+			{
+				int k = mTopoFunctions.IndexOf(to);
+				if (k >= 0 && k < i)
+					heat[i] += heat[k] * mCallSiteWeight[j];
+			}
+		}
+
+		if (heat[i] > 0x1000000)
+			heat[i] = 0x1000000;
+	}
+
+	GrowingArray<int>	candidates(0);
+
+	for (int i = 0; i < n; i++)
+	{
+		Declaration* f = mTopoFunctions[i];
+		// Virtual methods are dispatched with a tail call, and have to stay in
+		// the same code as their dispatcher
+		if (f->mType == DT_CONST_FUNCTION && f->mValue && (f->mFlags & DTF_DEFINED) && !(f->mFlags & (DTF_NATIVE | DTF_INLINE | DTF_INTRINSIC | DTF_FUNC_ASSEMBLER)) && !(f->mBase->mFlags & DTF_VIRTUAL))
+			candidates.Push(i);
+	}
+
+	// Greedy selection by estimated run time saved per additional byte
+
+	int	size = 0, nnative = 0;
+	for (;;)
+	{
+		int		best = -1, bgrowth = 0;
+		int64	btime = 0;
+
+		for (int i = 0; i < candidates.Size(); i++)
+		{
+			int	k = candidates[i];
+			if (k >= 0)
+			{
+				int	growth = NativeCodeGrowth(mTopoFunctions[k]);
+
+				if (size + growth > mNativeBudget)
+					candidates[i] = -1;
+				else
+				{
+					int64	time = heat[k] * invokes[k];
+					if (best < 0 || time * bgrowth > btime * growth)
+					{
+						best = i;
+						btime = time;
+						bgrowth = growth;
+					}
+				}
+			}
+		}
+
+		if (best < 0)
+			break;
+
+		Declaration* f = mTopoFunctions[candidates[best]];
+		f->mFlags |= DTF_NATIVE;
+		size += bgrowth;
+		nnative++;
+
+		if (mCompilerOptions & COPT_VERBOSE2)
+			printf("Native <%s> %d bytes, %lld invokes\n", f->mQualIdent->mString, bgrowth, invokes[candidates[best]]);
+
+		candidates[best] = -1;
+	}
+
+	if (mCompilerOptions & COPT_VERBOSE)
+		printf("Native budget %d bytes, %d functions for %d bytes\n", mNativeBudget, nnative, size);
+}
+
 bool GlobalAnalyzer::MarkCycle(Declaration* rootDec, Declaration* procDec)
 {
 	if (rootDec == procDec)
@@ -658,7 +838,13 @@ void GlobalAnalyzer::AnalyzeProcedure(Expression* cexp, Expression* exp, Declara
 			if (mCompilerOptions & COPT_OPTIMIZE_CONST_EXPRESSIONS)
 				dec->mFlags |= DTF_FUNC_CONSTEXPR;
 			dec->mFlags |= DTF_FUNC_PURE;
+
+			int	loopDepth = mLoopDepth;
+			mLoopDepth = 0;
 			Analyze(exp, dec, false, false);
+			mLoopDepth = loopDepth;
+
+			dec->mWeightedComplexity += dec->mComplexity;
 
 			Declaration* pdec = dec->mBase->mParams;
 			int vi = 0;
@@ -732,6 +918,7 @@ void GlobalAnalyzer::AnalyzeAssembler(Expression* exp, Declaration* procDec)
 			{
 				AnalyzeProcedure(exp, adec->mValue, adec);
 				RegisterCall(procDec, adec);
+				adec->mFlags |= DTF_FUNC_ASMCALLED;
 			}
 		}
 
@@ -744,7 +931,7 @@ void GlobalAnalyzer::AnalyzeGlobalVariable(Declaration* dec)
 	while (dec->mType == DT_VARIABLE_REF)
 		dec = dec->mBase;
 
-	dec->mUseCount++;
+	dec->mUseCount += AccessWeight() * ZeroPageAccessGain(dec->mBase);
 
 	if (!(dec->mFlags & DTF_ANALYZED))
 	{
@@ -774,6 +961,7 @@ void GlobalAnalyzer::AnalyzeInit(Declaration* mdec)
 Declaration * GlobalAnalyzer::Analyze(Expression* exp, Declaration* procDec, bool lhs, bool aliasing)
 {
 	Declaration* ldec, * rdec;
+	int		complexity;
 
 	switch (exp->mType)
 	{
@@ -889,6 +1077,7 @@ Declaration * GlobalAnalyzer::Analyze(Expression* exp, Declaration* procDec, boo
 		else if (exp->mToken == TK_MUL)
 		{
 			ldec = Analyze(exp->mLeft, procDec, false, false);
+			AddPointerDeref(ldec);
 			procDec->mFlags &= ~DTF_FUNC_CONSTEXPR;
 			if (lhs)
 				procDec->mFlags &= ~DTF_FUNC_PURE;
@@ -920,6 +1109,7 @@ Declaration * GlobalAnalyzer::Analyze(Expression* exp, Declaration* procDec, boo
 		procDec->mComplexity += 10 * exp->mRight->mDecType->mSize;
 
 		ldec = Analyze(exp->mLeft, procDec, lhs, false);
+		AddPointerDeref(ldec);
 		if (ldec->mType == DT_VARIABLE || ldec->mType == DT_ARGUMENT)
 		{
 			ldec = ldec->mBase;
@@ -1108,8 +1298,12 @@ Declaration * GlobalAnalyzer::Analyze(Expression* exp, Declaration* procDec, boo
 
 		procDec->mComplexity += 20;
 
+		complexity = procDec->mComplexity;
+		mLoopDepth++;
 		ldec = Analyze(exp->mLeft, procDec, false, false);
 		rdec = Analyze(exp->mRight, procDec, false, false);
+		mLoopDepth--;
+		AddLoopComplexity(procDec, complexity);
 		break;
 	case EX_IF:
 		procDec->mComplexity += 20;
@@ -1128,17 +1322,25 @@ Declaration * GlobalAnalyzer::Analyze(Expression* exp, Declaration* procDec, boo
 
 		if (exp->mLeft->mRight)
 			ldec = Analyze(exp->mLeft->mRight, procDec, false, false);
+		complexity = procDec->mComplexity;
+		mLoopDepth++;
 		if (exp->mLeft->mLeft->mLeft)
 			ldec = Analyze(exp->mLeft->mLeft->mLeft, procDec, false, false);
 		rdec = Analyze(exp->mRight, procDec, false, false);
 		if (exp->mLeft->mLeft->mRight)
 			ldec = Analyze(exp->mLeft->mLeft->mRight, procDec, false, false);
+		mLoopDepth--;
+		AddLoopComplexity(procDec, complexity);
 		break;
 	case EX_DO:
 		procDec->mComplexity += 20;
 
+		complexity = procDec->mComplexity;
+		mLoopDepth++;
 		ldec = Analyze(exp->mLeft, procDec, false, false);
 		rdec = Analyze(exp->mRight, procDec, false, false);
+		mLoopDepth--;
+		AddLoopComplexity(procDec, complexity);
 		break;
 	case EX_BREAK:
 	case EX_CONTINUE:
@@ -1217,6 +1419,19 @@ void GlobalAnalyzer::RegisterCall(Declaration* from, Declaration* to)
 		if (to->mType == DT_VARIABLE || to->mType == DT_ARGUMENT)
 			to = to->mBase;
 
+		if (to->mType == DT_CONST_FUNCTION || to->mType == DT_TYPE_FUNCTION)
+		{
+			mCallSiteFrom.Push(from);
+			mCallSiteTo.Push(to);
+			mCallSiteWeight.Push(AccessWeight());
+		}
+		else if (to->mType == DT_TYPE_POINTER && to->mBase->mType == DT_TYPE_FUNCTION)
+		{
+			mCallSiteFrom.Push(from);
+			mCallSiteTo.Push(to->mBase);
+			mCallSiteWeight.Push(AccessWeight());
+		}
+
 		if (to->mType == DT_CONST_FUNCTION)
 		{
 			if (to->mFlags & DTF_DYNSTACK)
@@ -23,6 +23,7 @@ public:
 	void AnalyzeGlobalVariable(Declaration* dec);
 
 	uint64		mCompilerOptions;
+	int			mNativeBudget;
 
 protected:
 	Errors* mErrors;
@@ -30,6 +31,16 @@ protected:
 
 	GrowingArray<Declaration*>		mCalledFunctions, mCallingFunctions, mVariableFunctions, mFunctions, mTopoFunctions;
 	GrowingArray<Declaration*>		mGlobalVariables;
+	GrowingArray<Declaration*>		mCallSiteFrom, mCallSiteTo;
+	GrowingArray<int>				mCallSiteWeight;
+
+	int		mLoopDepth;
+
+	int AccessWeight(void) const;
+	void AddLoopComplexity(Declaration* procDec, int complexity);
+	int NativeCodeGrowth(Declaration* procDec) const;
+	void AutoNative(void);
+	void AddPointerDeref(Declaration* dec);
 
 	void AnalyzeInit(Declaration* mdec);
 	int CallerInvokes(Declaration* called);
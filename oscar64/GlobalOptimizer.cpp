@@ -22,8 +22,14 @@ static const uint64 OPTF_VAR_NO_FORWARD = (1UL << 13);
 static const uint64 OPTF_SINGLE_CALL = (1ULL << 14);
 static const uint64 OPTF_MULTI_CALL = (1ULL << 15);
 
+// Survive Reset, track functions modified by the previous round and
+// the functions that need another optimization pass in this round
+static const uint64 OPTF_CHANGED = (1ULL << 16);
+static const uint64 OPTF_DIRTY = (1ULL << 17);
+static const uint64 OPTF_VAR_WAS_MODIFIED = (1ULL << 18);
+
 GlobalOptimizer::GlobalOptimizer(Errors* errors, Linker* linker)
-	: mErrors(errors), mLinker(linker)
+	: mErrors(errors), mLinker(linker), mOptimizeAll(true), mNumFunctions(0), mNumGlobalVariables(0), mNumVariableFunctions(0)
 {
 
 }
@@ -39,7 +45,7 @@ void GlobalOptimizer::Reset(void)
 	{
 		Declaration* func = mFunctions[i];
 		Declaration* ftype = func->mBase;
-		func->mOptFlags = 0;
+		func->mOptFlags &= OPTF_CHANGED;
 		ftype->mOptFlags = 0;
 		func->mReturn = nullptr;
 
@@ -54,13 +60,63 @@ void GlobalOptimizer::Reset(void)
 
 	for (int i = 0; i < mGlobalVariables.Size(); i++)
 	{
-		mGlobalVariables[i]->mOptFlags = 0;
+		Declaration* dec = mGlobalVariables[i];
+		if (dec->mOptFlags & (OPTF_VAR_MODIFIED | OPTF_VAR_ADDRESS))
+			dec->mOptFlags = OPTF_VAR_WAS_MODIFIED;
+		else
+			dec->mOptFlags = 0;
 	}
 
 	mFunctions.SetSize(0);
 	mGlobalVariables.SetSize(0);
+	mVariableFunctions.SetSize(0);
 	mCalledFunctions.SetSize(0);
-	mCalledFunctions.SetSize(0);
+	mCallingFunctions.SetSize(0);
+}
+
+void GlobalOptimizer::MarkDirtyFunctions(void)
+{
+	// A function can only see different facts in this round, if it or
+	// one of its direct callers or callees was modified in the last round.
+	// Changes in the set of reachable objects or in the constness of a
+	// global variable can reach further and require a full round.
+
+	bool	all = mOptimizeAll;
+
+	if (mFunctions.Size() != mNumFunctions || mGlobalVariables.Size() != mNumGlobalVariables || mVariableFunctions.Size() != mNumVariableFunctions)
+		all = true;
+
+	for (int i = 0; !all && i < mGlobalVariables.Size(); i++)
+	{
+		Declaration* dec = mGlobalVariables[i];
+		if ((dec->mOptFlags & OPTF_VAR_WAS_MODIFIED) && !(dec->mOptFlags & (OPTF_VAR_MODIFIED | OPTF_VAR_ADDRESS)))
+			all = true;
+	}
+
+	mOptimizeAll = false;
+	mNumFunctions = mFunctions.Size();
+	mNumGlobalVariables = mGlobalVariables.Size();
+	mNumVariableFunctions = mVariableFunctions.Size();
+
+	if (!all)
+	{
+		for (int i = 0; i < mCalledFunctions.Size(); i++)
+		{
+			Declaration* from = mCallingFunctions[i], * to = mCalledFunctions[i];
+			if (from->mOptFlags & OPTF_CHANGED)
+				to->mOptFlags |= OPTF_DIRTY;
+			if (to->mOptFlags & OPTF_CHANGED)
+				from->mOptFlags |= OPTF_DIRTY;
+		}
+	}
+
+	for (int i = 0; i < mFunctions.Size(); i++)
+	{
+		Declaration* func = mFunctions[i];
+		if (all || (func->mOptFlags & OPTF_CHANGED))
+			func->mOptFlags |= OPTF_DIRTY;
+		func->mOptFlags &= ~OPTF_CHANGED;
+	}
 }
 
 void GlobalOptimizer::PropagateParamCommas(Expression*& fexp, Expression*& exp)
@@ -301,35 +357,44 @@ bool GlobalOptimizer::Optimize(void)
 #if DUMP_OPTS
 	printf("OPT---\n");
 #endif
+	MarkDirtyFunctions();
+
 	for (int i = 0; i < mFunctions.Size(); i++)
 	{
 		Declaration* func = mFunctions[i];
 		Declaration* ftype = func->mBase;
 
+		if (func->mOptFlags & OPTF_MULTI_CALL)
+		{
+			Declaration* pdata = ftype->mParams;
+			while (pdata)
+			{
+				pdata->mForwardCall = nullptr;
+				pdata->mForwardParam = nullptr;
+				pdata = pdata->mNext;
+			}
+		}
+
+		if (!(func->mOptFlags & OPTF_DIRTY))
+			continue;
+
+		func->mOptFlags &= ~OPTF_DIRTY;
+
+		bool	fchanged = false;
+
 		if (func->mValue && func->mValue->mType != EX_DISPATCH)
 		{
 #if DUMP_OPTS
 			printf("%s %08llx\n", mFunctions[i]->mQualIdent->mString, mFunctions[i]->mOptFlags);
 #endif
 			if (CheckUnusedLocals(func->mValue))
-				changed = true;
+				fchanged = true;
 
 			if (CheckConstReturns(func->mValue))
-				changed = true;
+				fchanged = true;
 
 			if (ReplaceGlobalConst(func->mValue))
-				changed = true;
-
-			if (func->mOptFlags & OPTF_MULTI_CALL)
-			{
-				Declaration* pdata = ftype->mParams;
-				while (pdata)
-				{
-					pdata->mForwardCall = nullptr;
-					pdata->mForwardParam = nullptr;
-					pdata = pdata->mNext;
-				}
-			}
+				fchanged = true;
 
 			if (!(func->mOptFlags & OPTF_FUNC_VARIABLE) && !(func->mBase->mFlags & DTF_VIRTUAL))
 			{
@@ -340,7 +405,7 @@ bool GlobalOptimizer::Optimize(void)
 #endif
 					RemoveValueReturn(func->mValue);
 					func->mBase->mBase = TheVoidTypeDeclaration;
-					changed = true;
+					fchanged = true;
 				}
 				else if (!(func->mOptFlags & OPTF_VAR_ADDRESS) && func->mBase->mBase && func->mBase->mBase->IsReference() && func->mBase->mBase->mBase->IsSimpleType())
 				{
@@ -348,7 +413,7 @@ bool GlobalOptimizer::Optimize(void)
 					printf("Demote reference return\n");
 #endif
 					func->mBase->mBase = func->mBase->mBase->mBase;
-					changed = true;
+					fchanged = true;
 				}
 
 				if (!(ftype->mFlags & DTF_VARIADIC))
@@ -370,7 +435,7 @@ bool GlobalOptimizer::Optimize(void)
 								pdec->mFlags |= DTF_FPARAM_UNUSED;
 								pdec->mVarIndex = func->mNumVars++;
 
-								changed = true;
+								fchanged = true;
 							}
 						}
 						else if (!(pdec->mOptFlags & OPTF_VAR_ADDRESS) && pdec->mBase->IsReference() && pdec->mBase->mBase->IsSimpleType())
@@ -385,7 +450,7 @@ bool GlobalOptimizer::Optimize(void)
 
 							UndoParamReference(func->mValue, pdec);
 
-							changed = true;
+							fchanged = true;
 						}
 						else if ((pdec->mOptFlags & OPTF_VAR_CONST) && !(pdec->mOptFlags & OPTF_VAR_ADDRESS))
 						{
@@ -395,7 +460,7 @@ bool GlobalOptimizer::Optimize(void)
 #if DUMP_OPTS
 								printf("Const parameter %s\n", pdec->mIdent ? pdec->mIdent->mString : "_");
 #endif
-								changed = true;
+								fchanged = true;
 							}
 						}
 
@@ -421,7 +486,7 @@ bool GlobalOptimizer::Optimize(void)
 #if DUMP_OPTS
 							printf("Const parameter %s\n", pdec->mIdent ? pdec->mIdent->mString : "_");
 #endif
-							changed = true;
+							fchanged = true;
 						}
 					}
 
@@ -430,6 +495,12 @@ bool GlobalOptimizer::Optimize(void)
 				}
 			}
 		}
+
+		if (fchanged)
+		{
+			func->mOptFlags |= OPTF_CHANGED;
+			changed = true;
+		}
 	}
 
 	return changed;
@@ -559,33 +630,22 @@ void GlobalOptimizer::RegisterCall(Declaration* from, Declaration* to)
 
 		if (to->mType == DT_CONST_FUNCTION)
 		{
-			if (!(to->mOptFlags & OPTF_CALLED))
-			{
-				to->mOptFlags |= OPTF_CALLED;
-				mCalledFunctions.Push(to);
-			}
+			to->mOptFlags |= OPTF_CALLED;
+			from->mOptFlags |= OPTF_CALLING;
 
-			if (!(from->mOptFlags & OPTF_CALLING))
+			if (from->mType == DT_CONST_FUNCTION)
 			{
-				from->mOptFlags |= OPTF_CALLING;
 				mCallingFunctions.Push(from);
+				mCalledFunctions.Push(to);
 			}
 		}
 		else if (to->mType == DT_TYPE_FUNCTION)
 		{
-			if (!(from->mOptFlags & OPTF_CALLING))
-			{
-				from->mOptFlags |= OPTF_CALLING;
-				mCallingFunctions.Push(from);
-			}
+			from->mOptFlags |= OPTF_CALLING;
 		}
 		else if (to->mType == DT_TYPE_POINTER && to->mBase->mType == DT_TYPE_FUNCTION)
 		{
-			if (!(from->mOptFlags & OPTF_CALLING))
-			{
-				from->mOptFlags |= OPTF_CALLING;
-				mCallingFunctions.Push(from);
-			}
+			from->mOptFlags |= OPTF_CALLING;
 		}
 	}
 }
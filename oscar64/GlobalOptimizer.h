@@ -23,8 +23,15 @@ protected:
 	Errors* mErrors;
 	Linker* mLinker;
 
-	ExpandingArray<Declaration*>		mCalledFunctions, mCallingFunctions, mVariableFunctions, mFunctions;
-	ExpandingArray<Declaration*>		mGlobalVariables;
+	// Call edges of the current round, mCallingFunctions[i] calls mCalledFunctions[i]
+	ExpandingArray<Declaration*>		mCalledFunctions, mCallingFunctions;
+	ExpandingArray<Declaration*>		mVariableFunctions, mFunctions, mGlobalVariables;
+
+	// Shape of the previous round, used to decide whether an incremental round is safe
+	bool								mOptimizeAll;
+	int									mNumFunctions, mNumGlobalVariables, mNumVariableFunctions;
+
+	void MarkDirtyFunctions(void);
 
 	void AnalyzeInit(Declaration* mdec);
 	Declaration* Analyze(Expression* exp, Declaration* procDec, uint32 flags);
@@ -9,11 +9,11 @@ Ident::~Ident()
 
 unsigned int IHash(const char* str)
 {
-	unsigned int	hash = 32324124;
+	unsigned int	hash = Ident::HashSeed;
 	int		i = 0;
 	while (str[i])
 	{
-		hash = hash * 123211 + str[i];
+		hash = Ident::HashChar(hash, str[i]);
 		i++;
 	}
 
@@ -33,7 +33,11 @@ Ident	*	UniqueIdents[0x10000];
 
 const Ident* Ident::Unique(const char* str)
 {
-	unsigned int hash = IHash(str);
+	return UniqueHashed(str, IHash(str));
+}
+
+const Ident* Ident::UniqueHashed(const char* str, unsigned int hash)
+{
 	int i = hash & 0xffff;
 	while (UniqueIdents[i])
 	{
@@ -8,8 +8,14 @@ public:
 	char		*	mString;
 	unsigned int	mHash;
 
+	// Hash of an identifier, built one character at a time
+
+	static const unsigned int HashSeed = 32324124;
+	static unsigned int HashChar(unsigned int hash, char c) { return hash * 123211 + c; }
+
 	static const Ident* Unique(const char* str);
 	static const Ident* Unique(const char* str, int id);
+	static const Ident* UniqueHashed(const char* str, unsigned int hash);
 	const Ident* Mangle(const char* str) const;
 	const Ident* PreMangle(const char* str) const;
 protected:
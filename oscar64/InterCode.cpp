@@ -5871,7 +5871,7 @@ void InterInstruction::Disassemble(FILE* file, InterCodeProcedure* proc)
 
 InterCodeBasicBlock::InterCodeBasicBlock(InterCodeProcedure * proc)
 	: mProc(proc),
-	mInstructions(nullptr), mEntryRenameTable(-1), mExitRenameTable(-1), mMergeTValues(nullptr), mMergeAValues(nullptr), mTrueJump(nullptr), mFalseJump(nullptr), mLoopPrefix(nullptr), mDominator(nullptr),
+	mInstructions(nullptr), mEntryRenameTable(-1), mExitRenameTable(-1), mMergeTValues(nullptr), mMergeAValues(nullptr), mTrueJump(nullptr), mFalseJump(nullptr), mLoopPrefix(nullptr), mDominator(nullptr), mDomNum(-1), mDomEnd(-1),
 	mEntryValueRange(IntegerValueRange()), mTrueValueRange(IntegerValueRange()), mFalseValueRange(IntegerValueRange()), 
 	mEntryParamValueRange(IntegerValueRange()), mTrueParamValueRange(IntegerValueRange()), mFalseParamValueRange(IntegerValueRange()), mLocalParamValueRange(IntegerValueRange()),
 	mLoadStoreInstructions(nullptr), mMemoryValueSize(0), mEntryMemoryValueSize(0)
@@ -6042,13 +6042,12 @@ void InterCodeBasicBlock::BuildDominatorTree(InterCodeBasicBlock* from)
 
 bool InterCodeBasicBlock::IsDominator(InterCodeBasicBlock* block)
 {
-	while (block)
-	{
-		if (block == this)
-			return true;
-		block = block->mDominator;
-	}
-	return false;
+	if (block == this)
+		return true;
+	else if (block && block->mDomNum >= 0 && mDomNum >= 0)
+		return mDomNum <= block->mDomNum && block->mDomNum < mDomEnd;
+	else
+		return false;
 }
 
 void InterCodeBasicBlock::CollectEntries(void)
@@ -10272,6 +10271,49 @@ bool InterCodeBasicBlock::BuildGlobalRequiredTempSet(NumberSet& fromRequiredTemp
 	return revisit;
 }
 
+static inline uint64 SignatureHash(uint64 hash, int value)
+{
+	return (hash ^ (hash >> 29) ^ uint32(value)) * 0x9e3779b97f4a7c15ULL;
+}
+
+uint64 InterCodeBasicBlock::DataFlowSignature(uint64 hash)
+{
+	if (!mVisited)
+	{
+		mVisited = true;
+
+		hash = SignatureHash(hash, mIndex);
+		hash = SignatureHash(hash, mTrueJump ? mTrueJump->mIndex : -1);
+		hash = SignatureHash(hash, mFalseJump ? mFalseJump->mIndex : -1);
+
+		for (int i = 0; i < mInstructions.Size(); i++)
+		{
+			const InterInstruction* ins = mInstructions[i];
+
+			hash = SignatureHash(hash, ins->mCode);
+			hash = SignatureHash(hash, ins->mDst.mTemp);
+			for (int j = 0; j < ins->mNumOperands; j++)
+				hash = SignatureHash(hash, ins->mSrc[j].mTemp);
+		}
+
+		hash = mLocalRequiredTemps.Hash(hash);
+		hash = mLocalProvidedTemps.Hash(hash);
+		hash = mEntryRequiredTemps.Hash(hash);
+		hash = mEntryProvidedTemps.Hash(hash);
+		hash = mEntryPotentialTemps.Hash(hash);
+		hash = mExitRequiredTemps.Hash(hash);
+		hash = mExitProvidedTemps.Hash(hash);
+		hash = mExitPotentialTemps.Hash(hash);
+		hash = mLocalUsedTemps.Hash(hash);
+		hash = mLocalModifiedTemps.Hash(hash);
+
+		if (mTrueJump) hash = mTrueJump->DataFlowSignature(hash);
+		if (mFalseJump) hash = mFalseJump->DataFlowSignature(hash);
+	}
+
+	return hash;
+}
+
 bool InterCodeBasicBlock::RemoveUnusedResultInstructions(void)
 {
 	bool	changed = false;
@@ -22285,8 +22327,8 @@ InterCodeProcedure::InterCodeProcedure(InterCodeModule * mod, const Location & l
 	mInterrupt(false), mHardwareInterrupt(false), mCompiled(false), mInterruptCalled(false), mDynamicStack(false), mAssembled(false),
 	mSaveTempsLinkerObject(nullptr), mValueReturn(false), mFramePointer(false),
 	mCheckUnreachable(true), mReturnType(IT_NONE), mCheapInline(false), mNoInline(false),
-	mDeclaration(nullptr), mGlobalsChecked(false), mDispatchedCall(false),
-	mNumRestricted(1),
+	mDeclaration(nullptr), mGlobalsChecked(false), mDispatchedCall(false), mDispatchesByteCode(false), mAssemblerCalled(false),
+	mNumRestricted(1), mDataFlowSignature(0), mDataFlowValid(false),
 	mReverseValueRange(IntegerValueRange()), mLocalValueRange(IntegerValueRange())
 {
 	mID = mModule->mProcedures.Size();
@@ -22460,11 +22502,39 @@ void InterCodeProcedure::BuildTraces(bool expand, bool dominators, bool compact)
 	ResetVisited();
 	mEntryBlock->CollectEntryBlocks(nullptr);
 
+	if (dominators)
+	{
+		DominatorTree<InterCodeBasicBlock>	tree;
+		BuildDominatorTree(tree);
+	}
+	else
+	{
+		ResetVisited();
+		for (int i = 0; i < mBlocks.Size(); i++)
+		{
+			mBlocks[i]->mDominator = nullptr;
+			mBlocks[i]->mDomNum = -1;
+		}
+	}
+}
+
+void InterCodeProcedure::BuildDominatorTree(DominatorTree<InterCodeBasicBlock>& tree)
+{
 	ResetVisited();
 	for (int i = 0; i < mBlocks.Size(); i++)
+	{
 		mBlocks[i]->mDominator = nullptr;
-	if (dominators)
-		mEntryBlock->BuildDominatorTree(nullptr);
+		mBlocks[i]->mDomNum = -1;
+	}
+
+	tree.Build(mEntryBlock);
+
+	ExpandingArray<InterCodeBasicBlock*> sd;
+	for (int i = 0; i < mBlocks.Size(); i++) { sd.Push(mBlocks[i]->mDominator); mBlocks[i]->mDominator = nullptr; }
+	mEntryBlock->BuildDominatorTree(nullptr);
+	for (int i = 0; i < mBlocks.Size(); i++) { if (sd[i] != mBlocks[i]->mDominator) fprintf(stderr, "IDOMMISMATCH %s %d: %d %d\n", mIdent->mString, mBlocks[i]->mIndex, sd[i] ? sd[i]->mIndex : -1, mBlocks[i]->mDominator ? mBlocks[i]->mDominator->mIndex : -1); mBlocks[i]->mDominator = sd[i]; }
+
+	ResetVisited();
 }
 
 void InterCodeProcedure::TrimBlocks(void)
@@ -22485,10 +22555,24 @@ void InterCodeProcedure::TrimBlocks(void)
 	mNumBlocks = j;
 }
 
+uint64 InterCodeProcedure::DataFlowSignature(void)
+{
+	ResetVisited();
+	return mEntryBlock->DataFlowSignature(SignatureHash(0, mTemporaries.Size()));
+}
+
 void InterCodeProcedure::BuildDataFlowSets(void)
 {
 	int	numTemps = mTemporaries.Size();
 
+	// The data flow sets are a function of the control flow graph and the
+	// temporaries used and defined by each instruction.  The signature covers
+	// these and the sets themselves, so a rebuild is only needed if a
+	// transformation changed the code or patched the sets since the last build.
+
+	if (mDataFlowValid && DataFlowSignature() == mDataFlowSignature)
+		return;
+
 	//
 	//	Build set with local provided/required temporaries
 	//
@@ -22513,6 +22597,9 @@ void InterCodeProcedure::BuildDataFlowSets(void)
 
 	ResetVisited();
 	mEntryBlock->CollectLocalUsedTemps(numTemps);
+
+	mDataFlowSignature = DataFlowSignature();
+	mDataFlowValid = true;
 }
 
 void InterCodeProcedure::RenameTemporaries(void)
@@ -22804,20 +22891,8 @@ void InterCodeProcedure::TempForwarding(bool reverse, bool checkloops)
 
 void InterCodeProcedure::RemoveUnusedInstructions(void)
 {
-	int	numTemps = mTemporaries.Size();
-
 	do {
-		ResetVisited();
-		mEntryBlock->BuildLocalTempSets(numTemps);
-
-		ResetVisited();
-		mEntryBlock->BuildGlobalProvidedTempSet(NumberSet(numTemps), NumberSet(numTemps));
-
-		NumberSet	totalRequired2(numTemps);
-
-		do {
-			ResetVisited();
-		} while (mEntryBlock->BuildGlobalRequiredTempSet(totalRequired2));
+		BuildDataFlowSets();
 
 		ResetVisited();
 	} while (mEntryBlock->RemoveUnusedResultInstructions());
@@ -23047,7 +23122,7 @@ void InterCodeProcedure::PromoteSimpleLocalsToTemp(InterMemory paramMemory, int
 			WarnUsedUndefinedVariables();
 
 			TempForwarding();
-		} while (GlobalConstantPropagation());
+		} while (SparseConditionalConstantPropagation());
 
 		//
 		// Now remove unused instructions
@@ -23466,6 +23541,12 @@ void InterCodeProcedure::Close(void)
 		ResetVisited();
 		mEntryBlock->CollectOuterFrame(0, size, mHasDynamicStack, mHasInlineAssembler, mCallsByteCode);
 
+		// A native dispatcher of byte code methods enters the interpreter
+		// in the frame of its caller
+		for (int i = 0; i < mCalledFunctions.Size(); i++)
+			if (mCalledFunctions[i]->mDispatchesByteCode)
+				mCallsByteCode = true;
+
 		if (mModule->mCompilerOptions & COPT_NATIVE)
 			mCallsByteCode = false;
 		mCommonFrameSize = size;
@@ -23745,7 +23826,7 @@ void InterCodeProcedure::Close(void)
 	do {
 		Disassemble("gcp+");
 		TempForwarding();
-	} while (GlobalConstantPropagation());
+	} while (SparseConditionalConstantPropagation());
 	Disassemble("gcp-");
 #endif
 
@@ -23950,7 +24031,7 @@ void InterCodeProcedure::Close(void)
 	do {
 		Disassemble("gcp+");
 		TempForwarding();
-	} while (GlobalConstantPropagation());
+	} while (SparseConditionalConstantPropagation());
 	Disassemble("gcp-");
 #endif
 
@@ -23999,7 +24080,7 @@ void InterCodeProcedure::Close(void)
 
 	do {
 		TempForwarding();
-	} while (GlobalConstantPropagation());
+	} while (SparseConditionalConstantPropagation());
 
 #endif
 
@@ -24184,8 +24265,10 @@ void InterCodeProcedure::Close(void)
 		DisassembleDebug("Rebuilt traces");
 #endif
 	}
-	else if (!mInterruptCalled && mNativeProcedure)
+	else if (!mInterruptCalled)
 	{
+		// Byte code procedures pass the static stacks of their callees through
+		// to their callers, native code may call native code via byte code
 //		mLinkerObject->mFlags |= LOBJF_STATIC_STACK;
 		mLinkerObject->mStackSection = mModule->mLinker->AddSection(mIdent->Mangle("@stack"), LST_STATIC_STACK);
 		mLinkerObject->mStackSection->mSections.Push(mModule->mParamLinkerSection);
@@ -24210,7 +24293,7 @@ void InterCodeProcedure::Close(void)
 	do {
 		DisassembleDebug("InConstP");
 		TempForwarding();
-	} while (GlobalConstantPropagation());
+	} while (SparseConditionalConstantPropagation());
 
 	BuildTraces(false);
 	DisassembleDebug("Rebuilt traces");
@@ -24326,7 +24409,7 @@ void InterCodeProcedure::Close(void)
 		BuildDataFlowSets();
 		do {
 			TempForwarding();
-		} while (GlobalConstantPropagation());
+		} while (SparseConditionalConstantPropagation());
 
 		DisassembleDebug("GlobalConstantPropagation");
 
@@ -25074,6 +25157,959 @@ bool InterCodeProcedure::GlobalConstantPropagation(void)
 	return mEntryBlock->PropagateConstTemps(ctemps);
 }
 
+bool InterCodeProcedure::SparseConditionalConstantPropagation(void)
+{
+	DominatorTree<InterCodeBasicBlock>	tree;
+	BuildDominatorTree(tree);
+
+	InterCodeSSA	ssa(this, tree);
+	ssa.Build();
+
+	bool	branches = false;
+	bool	changed = ssa.PropagateConstants(branches);
+
+	if (branches)
+	{
+		ResetVisited();
+		mEntryBlock->EliminateDeadBranches();
+
+		BuildTraces(false);
+		BuildDataFlowSets();
+	}
+
+	DisassembleDebug("SparseConditionalConstantPropagation");
+
+	return changed;
+}
+
+static int64 SSATypeMask(InterType type)
+{
+	switch (type)
+	{
+	case IT_BOOL:
+	case IT_INT8:
+		return 0xff;
+	case IT_INT16:
+		return 0xffff;
+	case IT_INT32:
+		return 0xffffffff;
+	default:
+		return 0;
+	}
+}
+
+static int64 SSASmear(int64 v)
+{
+	v |= v >> 1;
+	v |= v >> 2;
+	v |= v >> 4;
+	v |= v >> 8;
+	v |= v >> 16;
+	return v;
+}
+
+static bool SSAPureCode(InterCode code)
+{
+	return
+		code == IC_LOAD_TEMPORARY || code == IC_BINARY_OPERATOR || code == IC_UNARY_OPERATOR || code == IC_RELATIONAL_OPERATOR ||
+		code == IC_CONVERSION_OPERATOR || code == IC_LEA || code == IC_TYPECAST;
+}
+
+InterCodeSSA::InterCodeSSA(InterCodeProcedure* proc, const DominatorTree<InterCodeBasicBlock>& tree)
+	: mProc(proc), mTree(tree), mCTemps(nullptr)
+{
+}
+
+InterCodeSSA::~InterCodeSSA(void)
+{
+	for (int i = 0; i < mConstants.Size(); i++)
+		delete mConstants[i];
+}
+
+int InterCodeSSA::AddValue(int block, int temp, int ins)
+{
+	Value	v;
+	v.mConst = nullptr;
+	v.mMin = 0;
+	v.mMax = -1;
+	v.mBlock = block;
+	v.mTemp = temp;
+	v.mIns = ins;
+	v.mArgs = -1;
+	v.mNext = -1;
+	v.mUpdates = 0;
+	v.mState = VS_TOP;
+	mValues.Push(v);
+	return mValues.Size() - 1;
+}
+
+void InterCodeSSA::Build(void)
+{
+	int	numTemps = mProc->mTemporaries.Size();
+
+	int	n = mTree.Size();
+
+	ExpandingArray<int>	fill;
+
+	// Dominance frontiers, the entry block has an additional virtual predecessor
+
+	mFrontierHead.SetSize(n);
+	for (int i = 0; i < n; i++)
+		mFrontierHead[i] = -1;
+
+	for (int i = 0; i < n; i++)
+	{
+		if (mTree.mPredStart[i + 1] - mTree.mPredStart[i] + (i == 0 ? 1 : 0) > 1)
+		{
+			for (int j = mTree.mPredStart[i]; j < mTree.mPredStart[i + 1]; j++)
+			{
+				int	r = mTree.mPredEdges[j] >> 1;
+				while (i == 0 || r != mTree.mIDom[i])
+				{
+					if (mFrontierHead[r] < 0 || mFrontierBlock[mFrontierHead[r]] != i)
+					{
+						mFrontierBlock.Push(i);
+						mFrontierNext.Push(mFrontierHead[r]);
+						mFrontierHead[r] = mFrontierBlock.Size() - 1;
+					}
+					if (r == 0)
+						break;
+					r = mTree.mIDom[r];
+				}
+			}
+		}
+	}
+
+	// Instruction table, temporaries used before their definition in a block
+	// are global names that may need phis
+
+	mBlockIns.SetSize(n + 1);
+	for (int i = 0; i < n; i++)
+	{
+		mBlockIns[i] = mIns.Size();
+		InterCodeBasicBlock* block = mTree.mOrder[i];
+		for (int j = 0; j < block->mInstructions.Size(); j++)
+		{
+			mIns.Push(block->mInstructions[j]);
+			mInsBlock.Push(i);
+		}
+	}
+	mBlockIns[n] = mIns.Size();
+
+	mInsOps.SetSize(mIns.Size());
+	mInsDef.SetSize(mIns.Size());
+
+	ExpandingArray<int>	defBlock, defHead, defNodeBlock, defNodeNext;
+	NumberSet			global(numTemps);
+
+	defBlock.SetSize(numTemps);
+	defHead.SetSize(numTemps);
+	for (int t = 0; t < numTemps; t++)
+	{
+		defBlock[t] = -1;
+		defHead[t] = -1;
+	}
+
+	for (int i = 0; i < n; i++)
+	{
+		for (int j = mBlockIns[i]; j < mBlockIns[i + 1]; j++)
+		{
+			const InterInstruction* ins = mIns[j];
+			for (int k = 0; k < ins->mNumOperands; k++)
+			{
+				int	t = ins->mSrc[k].mTemp;
+				if (t >= 0 && defBlock[t] != i)
+					global += t;
+			}
+
+			int	t = ins->mDst.mTemp;
+			if (t >= 0 && defBlock[t] != i)
+			{
+				defBlock[t] = i;
+				defNodeBlock.Push(i);
+				defNodeNext.Push(defHead[t]);
+				defHead[t] = defNodeBlock.Size() - 1;
+			}
+		}
+	}
+
+	// Place phis on the iterated dominance frontiers
+
+	mValues.SetSize(0);
+	AddValue(-1, -1, -1);	// undefined value
+
+	mPhis.SetSize(n);
+	ExpandingArray<int>	phiMark, workMark, work;
+	phiMark.SetSize(n);
+	workMark.SetSize(n);
+	for (int i = 0; i < n; i++)
+	{
+		mPhis[i] = -1;
+		phiMark[i] = -1;
+		workMark[i] = -1;
+	}
+
+	for (int t = 0; t < numTemps; t++)
+	{
+		if (global[t] && defHead[t] >= 0)
+		{
+			for (int d = defHead[t]; d >= 0; d = defNodeNext[d])
+			{
+				workMark[defNodeBlock[d]] = t;
+				work.Push(defNodeBlock[d]);
+			}
+
+			while (work.Size() > 0)
+			{
+				int	b = work.Pop();
+				for (int f = mFrontierHead[b]; f >= 0; f = mFrontierNext[f])
+				{
+					int	fb = mFrontierBlock[f];
+					if (phiMark[fb] != t)
+					{
+						phiMark[fb] = t;
+
+						int	v = AddValue(fb, t, -1);
+						mValues[v].mArgs = mPhiArgs.Size();
+						mValues[v].mNext = mPhis[fb];
+						mPhis[fb] = v;
+						for (int j = mTree.mPredStart[fb]; j < mTree.mPredStart[fb + 1]; j++)
+							mPhiArgs.Push(0);
+
+						if (workMark[fb] != t)
+						{
+							workMark[fb] = t;
+							work.Push(fb);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Rename along the dominator tree
+
+	ExpandingArray<int>	current, saved;
+	current.SetSize(numTemps);
+	for (int t = 0; t < numTemps; t++)
+		current[t] = 0;
+
+	Rename(0, current, saved);
+
+	// Users of each value
+
+	mUserStart.SetSize(mValues.Size() + 1);
+	for (int i = 0; i <= mValues.Size(); i++)
+		mUserStart[i] = 0;
+	for (int i = 0; i < mIns.Size(); i++)
+	{
+		for (int k = 0; k < mIns[i]->mNumOperands; k++)
+		{
+			int	v = mOpValues[mInsOps[i] + k];
+			if (v > 0)
+				mUserStart[v + 1]++;
+		}
+	}
+	for (int i = 1; i < mValues.Size(); i++)
+	{
+		if (mValues[i].mIns < 0)
+		{
+			int	na = mTree.mPredStart[mValues[i].mBlock + 1] - mTree.mPredStart[mValues[i].mBlock];
+			for (int j = 0; j < na; j++)
+			{
+				int	v = mPhiArgs[mValues[i].mArgs + j];
+				if (v > 0)
+					mUserStart[v + 1]++;
+			}
+		}
+	}
+	for (int i = 0; i < mValues.Size(); i++)
+		mUserStart[i + 1] += mUserStart[i];
+
+	mUsers.SetSize(mUserStart[mValues.Size()]);
+	fill.SetSize(mValues.Size());
+	for (int i = 0; i < mValues.Size(); i++)
+		fill[i] = mUserStart[i];
+	for (int i = 0; i < mIns.Size(); i++)
+	{
+		for (int k = 0; k < mIns[i]->mNumOperands; k++)
+		{
+			int	v = mOpValues[mInsOps[i] + k];
+			if (v > 0)
+				mUsers[fill[v]++] = i;
+		}
+	}
+	for (int i = 1; i < mValues.Size(); i++)
+	{
+		if (mValues[i].mIns < 0)
+		{
+			int	na = mTree.mPredStart[mValues[i].mBlock + 1] - mTree.mPredStart[mValues[i].mBlock];
+			for (int j = 0; j < na; j++)
+			{
+				int	v = mPhiArgs[mValues[i].mArgs + j];
+				if (v > 0)
+					mUsers[fill[v]++] = -1 - i;
+			}
+		}
+	}
+}
+
+void InterCodeSSA::Rename(int block, ExpandingArray<int>& current, ExpandingArray<int>& saved)
+{
+	int	mark = saved.Size();
+
+	for (int v = mPhis[block]; v >= 0; v = mValues[v].mNext)
+	{
+		int	t = mValues[v].mTemp;
+		saved.Push(t);
+		saved.Push(current[t]);
+		current[t] = v;
+	}
+
+	for (int i = mBlockIns[block]; i < mBlockIns[block + 1]; i++)
+	{
+		const InterInstruction* ins = mIns[i];
+
+		mInsOps[i] = mOpValues.Size();
+		for (int k = 0; k < ins->mNumOperands; k++)
+		{
+			int	t = ins->mSrc[k].mTemp;
+			mOpValues.Push(t >= 0 ? current[t] : -1);
+		}
+
+		int	t = ins->mDst.mTemp;
+		if (t >= 0)
+		{
+			int	v = AddValue(block, t, i);
+			mInsDef[i] = v;
+			saved.Push(t);
+			saved.Push(current[t]);
+			current[t] = v;
+		}
+		else
+			mInsDef[i] = -1;
+	}
+
+	for (int k = 0; k < 2; k++)
+	{
+		int	s = mTree.Successor(block, k);
+		if (s >= 0)
+		{
+			for (int j = mTree.mPredStart[s]; j < mTree.mPredStart[s + 1]; j++)
+			{
+				if (mTree.mPredEdges[j] == 2 * block + k)
+				{
+					for (int v = mPhis[s]; v >= 0; v = mValues[v].mNext)
+						mPhiArgs[mValues[v].mArgs + j - mTree.mPredStart[s]] = current[mValues[v].mTemp];
+				}
+			}
+		}
+	}
+
+	for (int i = mTree.mDomStart[block]; i < mTree.mDomStart[block + 1]; i++)
+		Rename(mTree.mDomChildren[i], current, saved);
+
+	while (saved.Size() > mark)
+	{
+		int	v = saved.Pop();
+		int	t = saved.Pop();
+		current[t] = v;
+	}
+}
+
+void InterCodeSSA::SetConstant(Value& v, const InterInstruction* cins, InterType type)
+{
+	v.mState = VS_CONST;
+	v.mConst = cins;
+
+	int64	mask = SSATypeMask(type);
+	if (mask && (IsIntegerType(cins->mConst.mType) || cins->mConst.mType == IT_BOOL))
+		v.mMin = v.mMax = cins->mConst.mIntConst & mask;
+	else
+	{
+		v.mMin = 0;
+		v.mMax = -1;
+	}
+}
+
+void InterCodeSSA::Join(Value& v, const Value& w, InterType type) const
+{
+	if (w.mState == VS_TOP || v.mState == VS_BOTTOM)
+		;
+	else if (v.mState == VS_TOP || w.mState == VS_BOTTOM)
+	{
+		v.mState = w.mState;
+		v.mConst = w.mConst;
+		v.mMin = w.mMin;
+		v.mMax = w.mMax;
+	}
+	else if (v.mState == VS_CONST && w.mState == VS_CONST && (v.mMin <= v.mMax ? v.mMin == w.mMin && v.mMax == w.mMax : v.mConst->mConst.IsEqual(w.mConst->mConst)))
+		;
+	else if (v.mMin <= v.mMax && w.mMin <= w.mMax)
+	{
+		v.mState = VS_RANGE;
+		v.mConst = nullptr;
+		if (w.mMin < v.mMin)
+			v.mMin = w.mMin;
+		if (w.mMax > v.mMax)
+			v.mMax = w.mMax;
+		if (v.mMin == 0 && v.mMax == SSATypeMask(type))
+			v.mState = VS_BOTTOM;
+	}
+	else
+		v.mState = VS_BOTTOM;
+}
+
+void InterCodeSSA::Update(int value, Value& v)
+{
+	Value&		cv(mValues[value]);
+	InterType	type = mProc->mTemporaries[cv.mTemp];
+
+	Value		nv(cv);
+	Join(nv, v, type);
+
+	if (nv.mState != cv.mState || nv.mMin != cv.mMin || nv.mMax != cv.mMax)
+	{
+		// Widen integer ranges that do not settle, e.g. loop counters
+		nv.mUpdates++;
+		if (nv.mUpdates > 16 && nv.mState == VS_RANGE)
+			nv.mState = VS_BOTTOM;
+
+		cv = nv;
+		mValueWork.Push(value);
+	}
+}
+
+bool InterCodeSSA::OperandRange(int ins, int op, InterType type, int64& min, int64& max) const
+{
+	const InterOperand& sop(mIns[ins]->mSrc[op]);
+
+	// Constant operands may have a smaller type than the operation
+	int64	mask = SSATypeMask(type);
+	if (!mask)
+		return false;
+
+	min = 0;
+	max = mask;
+
+	if (sop.mTemp < 0)
+	{
+		if (sop.mType == IT_POINTER || sop.mType == IT_FLOAT)
+			return false;
+		min = max = sop.mIntConst & mask;
+	}
+	else if (mProc->mTemporaries[sop.mTemp] == type)
+	{
+		const Value& v(mValues[mOpValues[mInsOps[ins] + op]]);
+		if ((v.mState == VS_CONST || v.mState == VS_RANGE) && v.mMin <= v.mMax)
+		{
+			min = v.mMin;
+			max = v.mMax;
+		}
+	}
+
+	return true;
+}
+
+void InterCodeSSA::EvaluateRange(int ins, Value& v)
+{
+	const InterInstruction* iins = mIns[ins];
+
+	int64	mask = SSATypeMask(iins->mDst.mType);
+
+	v.mState = VS_BOTTOM;
+	if (!mask)
+		return;
+
+	int64	amin, amax, bmin, bmax;
+	bool	valid = false;
+
+	switch (iins->mCode)
+	{
+	case IC_BINARY_OPERATOR:
+		if (OperandRange(ins, 1, iins->mDst.mType, amin, amax) && OperandRange(ins, 0, iins->mDst.mType, bmin, bmax))
+		{
+			switch (iins->mOperator)
+			{
+			case IA_ADD:
+				v.mMin = amin + bmin;
+				v.mMax = amax + bmax;
+				valid = v.mMax <= mask;
+				break;
+			case IA_SUB:
+				v.mMin = amin - bmax;
+				v.mMax = amax - bmin;
+				valid = amin >= bmax;
+				break;
+			case IA_MUL:
+				v.mMin = amin * bmin;
+				v.mMax = amax * bmax;
+				valid = bmax == 0 || amax <= mask / bmax;
+				break;
+			case IA_AND:
+				v.mMin = 0;
+				v.mMax = amax < bmax ? amax : bmax;
+				valid = true;
+				break;
+			case IA_OR:
+				v.mMin = amin > bmin ? amin : bmin;
+				v.mMax = SSASmear(amax > bmax ? amax : bmax);
+				valid = true;
+				break;
+			case IA_XOR:
+				v.mMin = 0;
+				v.mMax = SSASmear(amax > bmax ? amax : bmax);
+				valid = true;
+				break;
+			case IA_SHR:
+				if (bmin == bmax && bmin < 32)
+				{
+					v.mMin = amin >> bmin;
+					v.mMax = amax >> bmin;
+					valid = true;
+				}
+				break;
+			case IA_SHL:
+				if (bmin == bmax && bmin < 32)
+				{
+					v.mMin = amin << bmin;
+					v.mMax = amax << bmin;
+					valid = v.mMax <= mask;
+				}
+				break;
+			case IA_DIVU:
+				if (bmin > 0)
+				{
+					v.mMin = amin / bmax;
+					v.mMax = amax / bmin;
+					valid = true;
+				}
+				break;
+			case IA_MODU:
+				if (bmin > 0)
+				{
+					v.mMin = 0;
+					v.mMax = amax < bmax - 1 ? amax : bmax - 1;
+					valid = true;
+				}
+				break;
+			}
+		}
+		break;
+
+	case IC_UNARY_OPERATOR:
+		if (iins->mOperator == IA_NOT && OperandRange(ins, 0, iins->mDst.mType, amin, amax))
+		{
+			v.mMin = mask - amax;
+			v.mMax = mask - amin;
+			valid = true;
+		}
+		break;
+
+	case IC_CONVERSION_OPERATOR:
+		if (OperandRange(ins, 0, iins->mSrc[0].mType, amin, amax))
+		{
+			switch (iins->mOperator)
+			{
+			case IA_EXT8TO16U:
+			case IA_EXT8TO32U:
+			case IA_EXT16TO32U:
+				valid = true;
+				break;
+			case IA_EXT8TO16S:
+			case IA_EXT8TO32S:
+			case IA_EXT16TO32S:
+				valid = amax <= (SSATypeMask(iins->mSrc[0].mType) >> 1);
+				break;
+			}
+			v.mMin = amin;
+			v.mMax = amax;
+		}
+		break;
+
+	case IC_RELATIONAL_OPERATOR:
+	{
+		InterType	ctype = iins->mSrc[0].mTemp >= 0 ? iins->mSrc[0].mType : iins->mSrc[1].mType;
+		if (OperandRange(ins, 1, ctype, amin, amax) && OperandRange(ins, 0, ctype, bmin, bmax))
+		{
+			InterOperator	op = iins->mOperator;
+			int64			smask = SSATypeMask(ctype) >> 1;
+
+			// Signed compares of non negative ranges are unsigned compares
+			if (amax <= smask && bmax <= smask)
+			{
+				switch (op)
+				{
+				case IA_CMPGES: op = IA_CMPGEU; break;
+				case IA_CMPLES: op = IA_CMPLEU; break;
+				case IA_CMPGS: op = IA_CMPGU; break;
+				case IA_CMPLS: op = IA_CMPLU; break;
+				}
+			}
+
+			int	r = -1;
+			switch (op)
+			{
+			case IA_CMPEQ:
+				if (amax < bmin || bmax < amin) r = 0;
+				break;
+			case IA_CMPNE:
+				if (amax < bmin || bmax < amin) r = 1;
+				break;
+			case IA_CMPLU:
+				if (amax < bmin) r = 1; else if (amin >= bmax) r = 0;
+				break;
+			case IA_CMPLEU:
+				if (amax <= bmin) r = 1; else if (amin > bmax) r = 0;
+				break;
+			case IA_CMPGU:
+				if (amin > bmax) r = 1; else if (amax <= bmin) r = 0;
+				break;
+			case IA_CMPGEU:
+				if (amin >= bmax) r = 1; else if (amax < bmin) r = 0;
+				break;
+			}
+
+			if (r >= 0)
+			{
+				InterInstruction* cins = new InterInstruction(iins->mLocation, IC_CONSTANT);
+				cins->mDst = iins->mDst;
+				cins->mConst.mType = IT_BOOL;
+				cins->mConst.mIntConst = r;
+				mConstants.Push(cins);
+				SetConstant(v, cins, iins->mDst.mType);
+				return;
+			}
+		}
+
+		v.mMin = 0;
+		v.mMax = 1;
+		valid = true;
+	}	break;
+	}
+
+	if (valid && v.mMin >= 0 && v.mMin <= v.mMax && v.mMax <= mask && !(v.mMin == 0 && v.mMax == mask))
+	{
+		v.mState = VS_RANGE;
+		v.mConst = nullptr;
+	}
+	else
+		v.mState = VS_BOTTOM;
+}
+
+void InterCodeSSA::EvaluateInstruction(int ins)
+{
+	InterInstruction* iins = mIns[ins];
+
+	int	d = mInsDef[ins];
+	if (d >= 0)
+	{
+		Value	v(mValues[d]);
+
+		if (iins->mCode == IC_CONSTANT)
+			SetConstant(v, iins, mProc->mTemporaries[iins->mDst.mTemp]);
+		else if (iins->mCode == IC_LOAD_TEMPORARY)
+		{
+			if (iins->mSrc[0].mType == iins->mDst.mType)
+				v = mValues[mOpValues[mInsOps[ins]]];
+			else
+				v.mState = VS_BOTTOM;
+		}
+		else if (SSAPureCode(iins->mCode))
+		{
+			bool	top = false, constant = true;
+			for (int k = 0; k < iins->mNumOperands; k++)
+			{
+				if (iins->mSrc[k].mTemp >= 0)
+				{
+					const Value& w(mValues[mOpValues[mInsOps[ins] + k]]);
+					if (w.mState == VS_TOP)
+						top = true;
+					else if (w.mState != VS_CONST)
+						constant = false;
+				}
+			}
+
+			if (top)
+				v.mState = VS_TOP;
+			else
+			{
+				bool	folded = false;
+
+				if (constant)
+				{
+					// Fold a copy of the instruction with the constant operands
+					InterInstruction* cins = iins->Clone();
+					for (int k = 0; k < iins->mNumOperands; k++)
+					{
+						if (iins->mSrc[k].mTemp >= 0)
+							mCTemps[iins->mSrc[k].mTemp] = (InterInstruction *)mValues[mOpValues[mInsOps[ins] + k]].mConst;
+					}
+
+					while (cins->mCode != IC_CONSTANT && cins->PropagateConstTemps(mCTemps))
+						;
+					if (cins->mCode != IC_CONSTANT)
+						cins->ConstantFolding();
+
+					for (int k = 0; k < iins->mNumOperands; k++)
+					{
+						if (iins->mSrc[k].mTemp >= 0)
+							mCTemps[iins->mSrc[k].mTemp] = nullptr;
+					}
+
+					if (cins->mCode == IC_CONSTANT)
+					{
+						mConstants.Push(cins);
+						SetConstant(v, cins, mProc->mTemporaries[iins->mDst.mTemp]);
+						folded = true;
+					}
+					else
+						delete cins;
+				}
+
+				if (!folded)
+					EvaluateRange(ins, v);
+			}
+		}
+		else
+			v.mState = VS_BOTTOM;
+
+		Update(d, v);
+	}
+
+	if (ins + 1 == mBlockIns[mInsBlock[ins] + 1])
+		EvaluateEdges(mInsBlock[ins]);
+}
+
+void InterCodeSSA::EvaluatePhi(int phi)
+{
+	const Value&	p(mValues[phi]);
+	InterType		type = mProc->mTemporaries[p.mTemp];
+	int				b = p.mBlock;
+
+	Value	v(p);
+	v.mState = VS_TOP;
+
+	for (int j = mTree.mPredStart[b]; j < mTree.mPredStart[b + 1]; j++)
+	{
+		if (mEdgeExecutable[mTree.mPredEdges[j]])
+			Join(v, mValues[mPhiArgs[p.mArgs + j - mTree.mPredStart[b]]], type);
+	}
+
+	Update(phi, v);
+}
+
+int InterCodeSSA::BranchCondition(int ins) const
+{
+	const InterOperand&	sop(mIns[ins]->mSrc[0]);
+	const InterOperand*	cop = &sop;
+
+	if (sop.mTemp >= 0)
+	{
+		const Value& v(mValues[mOpValues[mInsOps[ins]]]);
+		switch (v.mState)
+		{
+		case VS_TOP:
+			return -1;
+		case VS_RANGE:
+			if (v.mMin > 0)
+				return 1;
+			else if (v.mMax == 0)
+				return 0;
+			return 2;
+		case VS_BOTTOM:
+			return 2;
+		}
+		cop = &(v.mConst->mConst);
+	}
+
+	if (IsIntegerType(cop->mType) || cop->mType == IT_BOOL)
+		return cop->mIntConst != 0 ? 1 : 0;
+	else if (cop->mType == IT_FLOAT)
+		return cop->mFloatConst != 0 ? 1 : 0;
+	else if (cop->mType == IT_POINTER)
+	{
+		if (cop->mMemory == IM_ABSOLUTE)
+			return cop->mIntConst != 0 ? 1 : 0;
+		else if (cop->mMemory == IM_GLOBAL || cop->mMemory == IM_LOCAL || cop->mMemory == IM_PARAM || cop->mMemory == IM_FPARAM)
+			return 1;
+	}
+
+	return 2;
+}
+
+void InterCodeSSA::EvaluateEdges(int block)
+{
+	bool	t = true, f = true;
+
+	if (mBlockIns[block + 1] > mBlockIns[block])
+	{
+		int	ins = mBlockIns[block + 1] - 1;
+		switch (mIns[ins]->mCode)
+		{
+		case IC_BRANCH:
+			switch (BranchCondition(ins))
+			{
+			case -1:
+				t = f = false;
+				break;
+			case 0:
+				t = false;
+				break;
+			case 1:
+				f = false;
+				break;
+			}
+			break;
+		case IC_JUMP:
+			f = false;
+			break;
+		case IC_JUMPF:
+			t = false;
+			break;
+		}
+	}
+
+	if (t)
+		MarkEdge(block, 0);
+	if (f)
+		MarkEdge(block, 1);
+}
+
+void InterCodeSSA::MarkEdge(int block, int edge)
+{
+	int	s = mTree.Successor(block, edge);
+	if (s >= 0 && !mEdgeExecutable[2 * block + edge])
+	{
+		mEdgeExecutable[2 * block + edge] = true;
+		if (!mBlockExecutable[s])
+		{
+			mBlockExecutable[s] = true;
+			mBlockWork.Push(s);
+		}
+		else
+		{
+			for (int v = mPhis[s]; v >= 0; v = mValues[v].mNext)
+				EvaluatePhi(v);
+		}
+	}
+}
+
+bool InterCodeSSA::PropagateConstants(bool& branches)
+{
+	int	n = mTree.mOrder.Size();
+
+	mEdgeExecutable.SetSize(2 * n);
+	mBlockExecutable.SetSize(n);
+	for (int i = 0; i < n; i++)
+	{
+		mEdgeExecutable[2 * i] = false;
+		mEdgeExecutable[2 * i + 1] = false;
+		mBlockExecutable[i] = false;
+	}
+	mCTemps.SetSize(mProc->mTemporaries.Size(), true);
+
+	// Optimistic propagation over the executable edges only
+
+	mBlockExecutable[0] = true;
+	mBlockWork.Push(0);
+
+	while (mBlockWork.Size() > 0 || mValueWork.Size() > 0)
+	{
+		while (mValueWork.Size() > 0)
+		{
+			int	v = mValueWork.Pop();
+			for (int j = mUserStart[v]; j < mUserStart[v + 1]; j++)
+			{
+				int	u = mUsers[j];
+				if (u >= 0)
+				{
+					if (mBlockExecutable[mInsBlock[u]])
+						EvaluateInstruction(u);
+				}
+				else if (mBlockExecutable[mValues[-1 - u].mBlock])
+					EvaluatePhi(-1 - u);
+			}
+		}
+
+		if (mBlockWork.Size() > 0)
+		{
+			int	b = mBlockWork.Pop();
+
+			for (int v = mPhis[b]; v >= 0; v = mValues[v].mNext)
+				EvaluatePhi(v);
+			for (int i = mBlockIns[b]; i < mBlockIns[b + 1]; i++)
+				EvaluateInstruction(i);
+			if (mBlockIns[b] == mBlockIns[b + 1])
+				EvaluateEdges(b);
+		}
+	}
+
+	// Replace constant results and operands, and decided branches
+
+	bool	changed = false;
+
+	for (int b = 0; b < n; b++)
+	{
+		if (mBlockExecutable[b])
+		{
+			for (int i = mBlockIns[b]; i < mBlockIns[b + 1]; i++)
+			{
+				InterInstruction* ins = mIns[i];
+
+				int	d = mInsDef[i];
+				if (d >= 0 && mValues[d].mState == VS_CONST && ins->mCode != IC_CONSTANT && SSAPureCode(ins->mCode))
+				{
+					ins->mCode = IC_CONSTANT;
+					ins->mConst = mValues[d].mConst->mConst;
+					for (int k = 0; k < ins->mNumOperands; k++)
+						ins->mSrc[k].mTemp = -1;
+					ins->mNumOperands = 0;
+					changed = true;
+				}
+				else
+				{
+					int	temps[4], nt = 0;
+					for (int k = 0; k < ins->mNumOperands && nt < 4; k++)
+					{
+						int	t = ins->mSrc[k].mTemp;
+						if (t >= 0)
+						{
+							const Value& v(mValues[mOpValues[mInsOps[i] + k]]);
+							if (v.mState == VS_CONST)
+							{
+								mCTemps[t] = (InterInstruction*)v.mConst;
+								temps[nt++] = t;
+							}
+						}
+					}
+
+					if (nt > 0)
+					{
+						while (ins->PropagateConstTemps(mCTemps))
+							changed = true;
+						for (int k = 0; k < nt; k++)
+							mCTemps[temps[k]] = nullptr;
+					}
+				}
+
+				ins->ConstantFolding();
+
+				if (i + 1 == mBlockIns[b + 1] && ins->mCode == IC_BRANCH && mEdgeExecutable[2 * b] != mEdgeExecutable[2 * b + 1])
+				{
+					ins->mCode = mEdgeExecutable[2 * b] ? IC_JUMP : IC_JUMPF;
+					ins->mSrc[0].mTemp = -1;
+					ins->mNumOperands = 0;
+					changed = true;
+					branches = true;
+				}
+			}
+		}
+	}
+
+	return changed;
+}
+
 void InterCodeProcedure::RemoveUnusedMallocs(void)
 {
 	ResetVisited();
@@ -25449,6 +26485,7 @@ bool InterCodeModule::Disassemble(const char* filename)
 	fopen_s(&file, filename, "wb");
 	if (file)
 	{
+		setvbuf(file, nullptr, _IOFBF, 0x10000);
 		for (int i = 0; i < mProcedures.Size(); i++)
 		{
 			InterCodeProcedure* proc = mProcedures[i];
@@ -8,6 +8,7 @@
 #include "MachineTypes.h"
 #include "Ident.h"
 #include "Linker.h"
+#include "Dominators.h"
 
 class Declaration;
 
@@ -259,6 +260,68 @@ public:
 	void Build(int from, int to);
 };
 
+// Static single assignment view of the temporaries of a procedure.  Every
+// definition and every phi at a dominance frontier gets a value number, the
+// intercode itself keeps its temporaries, so there is no SSA destruction.
+
+class InterCodeSSA
+{
+public:
+	InterCodeSSA(InterCodeProcedure* proc, const DominatorTree<InterCodeBasicBlock>& tree);
+	~InterCodeSSA(void);
+
+	void Build(void);
+
+	// Sparse conditional propagation of constants and integer ranges, returns
+	// true if the code changed, branches is set if a conditional branch was
+	// replaced by a jump
+	bool PropagateConstants(bool & branches);
+
+protected:
+	enum ValueState : uint8
+	{
+		VS_TOP,
+		VS_CONST,
+		VS_RANGE,
+		VS_BOTTOM
+	};
+
+	struct Value
+	{
+		const InterInstruction	*	mConst;
+		int64						mMin, mMax;				// Unsigned range of integer values
+		int							mBlock, mTemp, mIns;	// mIns is -1 for a phi
+		int							mArgs, mNext;			// Phi arguments and next phi in block
+		int							mUpdates;
+		ValueState					mState;
+	};
+
+	InterCodeProcedure					*	mProc;
+	const DominatorTree<InterCodeBasicBlock>	&	mTree;
+	ExpandingArray<int>						mFrontierHead, mFrontierBlock, mFrontierNext, mPhis;
+	ExpandingArray<InterInstruction*>		mIns;
+	ExpandingArray<int>						mInsBlock, mInsOps, mInsDef, mBlockIns, mOpValues, mPhiArgs;
+	ExpandingArray<Value>					mValues;
+	ExpandingArray<int>						mUserStart, mUsers, mValueWork, mBlockWork;
+	ExpandingArray<bool>					mEdgeExecutable, mBlockExecutable;
+	ExpandingArray<InterInstruction*>		mConstants;
+	GrowingInstructionPtrArray				mCTemps;
+
+	int AddValue(int block, int temp, int ins);
+	void Rename(int block, ExpandingArray<int>& current, ExpandingArray<int>& saved);
+
+	bool OperandRange(int ins, int op, InterType type, int64& min, int64& max) const;
+	int BranchCondition(int ins) const;
+	void SetConstant(Value& v, const InterInstruction* cins, InterType type);
+	void Join(Value& v, const Value& w, InterType type) const;
+	void Update(int value, Value& v);
+	void EvaluateRange(int ins, Value& v);
+	void EvaluateInstruction(int ins);
+	void EvaluatePhi(int phi);
+	void EvaluateEdges(int block);
+	void MarkEdge(int block, int edge);
+};
+
 class InterVariable
 {
 public:
@@ -376,7 +439,7 @@ class InterCodeBasicBlock
 {
 public:
 	InterCodeProcedure			*	mProc;
-	int								mIndex, mNumEntries, mNumEntered, mTraceIndex;
+	int								mIndex, mNumEntries, mNumEntered, mTraceIndex, mDomNum, mDomEnd;
 	InterCodeBasicBlock			*	mTrueJump, * mFalseJump, * mLoopPrefix, * mDominator;
 	GrowingInstructionArray			mInstructions;
 
@@ -430,7 +493,6 @@ public:
 	void CollectEntries(void);
 	void CollectEntryBlocks(InterCodeBasicBlock* from);
 	void GenerateTraces(bool expand, bool compact);
-	void BuildDominatorTree(InterCodeBasicBlock * from);
 
 	bool MergeSameConditionTraces(void);
 
@@ -456,6 +518,7 @@ public:
 	void BuildLocalTempSets(int num);
 	void BuildGlobalProvidedTempSet(const NumberSet & fromProvidedTemps, const NumberSet& potentialProvidedTemps);
 	bool BuildGlobalRequiredTempSet(NumberSet& fromRequiredTemps);
+	uint64 DataFlowSignature(uint64 hash);
 	bool RemoveUnusedResultInstructions(void);
 	void BuildCallerSaveTempSet(NumberSet& callerSaveTemps);
 	void BuildConstTempSets(void);
@@ -556,6 +619,7 @@ public:
 	bool MoveTrainCrossBlock(void);
 	bool HoistCommonConditionalPath(void);
 	bool IsDominator(InterCodeBasicBlock* block);
+	void BuildDominatorTree(InterCodeBasicBlock * from);
 	bool IsDirectDominatorBlock(InterCodeBasicBlock* block);
 	bool IsDirectLoopPathBlock(InterCodeBasicBlock* block);
 	bool CollectBlocksToDominator(InterCodeBasicBlock* dblock, ExpandingArray<InterCodeBasicBlock*>& body);
@@ -699,6 +763,8 @@ protected:
 	TempForwardingTable					mTempForwardingTable;
 	GrowingInstructionPtrArray			mValueForwardingTable;
 	GrowingIntegerValueRangeArray		mLocalValueRange, mReverseValueRange;
+	uint64								mDataFlowSignature;
+	bool								mDataFlowValid;
 
 	void ResetVisited(void);
 	void ResetEntryBlocks(void);
@@ -711,7 +777,7 @@ public:
 	int									mTempSize, mCommonFrameSize, mCallerSavedTemps, mFreeCallerSavedTemps, mFastCallBase, mNumRestricted;
 	bool								mLeafProcedure, mNativeProcedure, mCallsFunctionPointer, mHasDynamicStack, mHasInlineAssembler, mCallsByteCode, mFastCallProcedure;
 	bool								mInterrupt, mHardwareInterrupt, mCompiled, mInterruptCalled, mValueReturn, mFramePointer, mDynamicStack, mAssembled;
-	bool								mDispatchedCall;
+	bool								mDispatchedCall, mDispatchesByteCode, mAssemblerCalled;
 	bool								mCheckUnreachable;
 	GrowingInterCodeProcedurePtrArray	mCalledFunctions;
 	bool								mCheapInline;
@@ -763,13 +829,16 @@ public:
 protected:
 	void BuildLocalAliasTable(void);
 	void BuildTraces(bool expand, bool dominators = true, bool compact = false);
+	void BuildDominatorTree(DominatorTree<InterCodeBasicBlock>& tree);
 	void TrimBlocks(void);
 	void EarlyBranchElimination(void);
 	void BuildDataFlowSets(void);
+	uint64 DataFlowSignature(void);
 	void RenameTemporaries(void);
 	void TempForwarding(bool reverse = false, bool checkloops = false);
 	void RemoveUnusedInstructions(void);
 	bool GlobalConstantPropagation(void);
+	bool SparseConditionalConstantPropagation(void);
 	bool PropagateNonLocalUsedTemps(void);
 	void BuildLoopPrefix(void);
 	void SingleAssignmentForwarding(void);
@@ -899,6 +899,8 @@ void InterCodeGenerator::TranslateAssembler(InterCodeModule* mod, Declaration *
 		if (cexp->mAsmInsType != ASMIT_BYTE)
 		{
 			int	opcode = AsmInsOpcodes[cexp->mAsmInsType][cexp->mAsmInsMode];
+			if (opcode < 0)
+				mErrors->Error(cexp->mLocation, EERR_ASM_INVALID_MODE, "Invalid addressing mode", AsmInstructionNames[cexp->mAsmInsType]);
 			d[offset++] = opcode;
 		}
 
@@ -1019,6 +1021,7 @@ void InterCodeGenerator::TranslateAssembler(InterCodeModule* mod, Declaration *
 		case ASMIM_ZERO_PAGE_X:
 		case ASMIM_INDIRECT_X:
 		case ASMIM_INDIRECT_Y:
+		case ASMIM_ZERO_PAGE_INDIRECT:
 			if (!aexp)
 				mErrors->Error(cexp->mLocation, EERR_ASM_INVALD_OPERAND, "Missing assembler operand");
 			else if (aexp->mType == DT_VARIABLE_REF)
@@ -1265,6 +1268,16 @@ void InterCodeGenerator::TranslateAssembler(InterCodeModule* mod, Declaration *
 	assert(offset == osize);
 }
 
+int InterCodeGenerator::BulkCopyLimit(int limit) const
+{
+	// Larger constant sized memcpy/memset are expanded inline when optimizing for
+	// speed, the native backend emits page unrolled loops for these
+	if (mCompilerOptions & COPT_OPTIMIZE_AUTO_UNROLL)
+		return 8192;
+	else
+		return limit;
+}
+
 void InterCodeGenerator::BuildSwitchTree(InterCodeProcedure* proc, Expression* exp, InterCodeBasicBlock* block, InlineMapper * inlineMapper, ExValue v, const SwitchNodeArray& nodes, int left, int right, int vleft, int vright, InterCodeBasicBlock* dblock)
 {
 	if (right - left < 3)
@@ -3772,7 +3785,7 @@ InterCodeGenerator::ExValue InterCodeGenerator::TranslateExpression(Declaration*
 					if (exp->mRight->mType == EX_LIST)
 					{
 						Expression* tex = exp->mRight->mLeft, * sex = exp->mRight->mRight->mLeft, * nex = exp->mRight->mRight->mRight;
-						if (nex && nex->mType == EX_CONSTANT && nex->mDecValue->mType == DT_CONST_INTEGER && nex->mDecValue->mInteger < 512)
+						if (nex && nex->mType == EX_CONSTANT && nex->mDecValue->mType == DT_CONST_INTEGER && nex->mDecValue->mInteger < BulkCopyLimit(512))
 						{
 							vl = TranslateExpression(procType, proc, block, tex, destack, gotos, breakBlock, continueBlock, inlineMapper);
 							if (vl.mType->mType == DT_TYPE_ARRAY)
@@ -3816,7 +3829,7 @@ InterCodeGenerator::ExValue InterCodeGenerator::TranslateExpression(Declaration*
 					if (exp->mRight->mType == EX_LIST)
 					{
 						Expression* tex = exp->mRight->mLeft, * sex = exp->mRight->mRight->mLeft, * nex = exp->mRight->mRight->mRight;
-						if (nex && nex->mType == EX_CONSTANT && nex->mDecValue->mType == DT_CONST_INTEGER && nex->mDecValue->mInteger <= 1024)
+						if (nex && nex->mType == EX_CONSTANT && nex->mDecValue->mType == DT_CONST_INTEGER && nex->mDecValue->mInteger <= BulkCopyLimit(1024))
 						{
 							vl = TranslateExpression(procType, proc, block, tex, destack, gotos, breakBlock, continueBlock, inlineMapper);
 							if (vl.mType->mType == DT_TYPE_ARRAY)
@@ -3854,7 +3867,7 @@ InterCodeGenerator::ExValue InterCodeGenerator::TranslateExpression(Declaration*
 					if (exp->mRight->mType == EX_LIST)
 					{
 						Expression* tex = exp->mRight->mLeft, * nex = exp->mRight->mRight;
-						if (nex && nex->mType == EX_CONSTANT && nex->mDecValue->mType == DT_CONST_INTEGER && nex->mDecValue->mInteger <= 1024)
+						if (nex && nex->mType == EX_CONSTANT && nex->mDecValue->mType == DT_CONST_INTEGER && nex->mDecValue->mInteger <= BulkCopyLimit(1024))
 						{
 							vl = TranslateExpression(procType, proc, block, tex, destack, gotos, breakBlock, continueBlock, inlineMapper);
 							if (vl.mType->mType == DT_TYPE_ARRAY)
@@ -5293,8 +5306,11 @@ InterCodeGenerator::ExValue InterCodeGenerator::TranslateExpression(Declaration*
 			Declaration* dinit = exp->mLeft->mLeft->mDecValue->mValue->mDecValue->mParams;
 			while (dinit)
 			{
-				proc->mModule->mProcedures[dinit->mValue->mDecValue->mVarIndex]->mDispatchedCall = true;
-				proc->AddCalledFunction(proc->mModule->mProcedures[dinit->mValue->mDecValue->mVarIndex]);
+				InterCodeProcedure* dproc = proc->mModule->mProcedures[dinit->mValue->mDecValue->mVarIndex];
+				dproc->mDispatchedCall = true;
+				if (!dproc->mNativeProcedure)
+					proc->mDispatchesByteCode = true;
+				proc->AddCalledFunction(dproc);
 				dinit = dinit->mNext;
 			}
 
@@ -5970,6 +5986,9 @@ InterCodeProcedure* InterCodeGenerator::TranslateProcedure(InterCodeModule * mod
 
 	if (dec->mFlags & DTF_FUNC_INTRCALLED)
 		proc->mInterruptCalled = true;
+
+	if (dec->mFlags & DTF_FUNC_ASMCALLED)
+		proc->mAssemblerCalled = true;
 	
 	if (dec->mFlags & DTF_DYNSTACK)
 		proc->mDynamicStack = true;
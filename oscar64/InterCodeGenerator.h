@@ -90,6 +90,7 @@ protected:
 	InterCodeBasicBlock* mMainInitBlock, *mMainStartupBlock;
 
 	Location MapLocation(Expression * exp, InlineMapper* inlineMapper);
+	int BulkCopyLimit(int limit) const;
 
 	void BuildSwitchTree(InterCodeProcedure* proc, Expression* exp, InterCodeBasicBlock* block, InlineMapper * inlineMapper, ExValue v, const SwitchNodeArray& nodes, int left, int right, int vleft, int vright, InterCodeBasicBlock* dblock);
 
@@ -260,8 +260,62 @@ bool Linker::IsSectionPlaced(LinkerSection* section)
 	return false;
 }
 
+void Linker::BuildAddressTable(void)
+{
+	// Earlier objects take precedence, as with the linear search
+
+	mAddressObjects.SetSize(0x10000);
+	for (int i = 0; i < 0x10000; i++)
+		mAddressObjects[i] = nullptr;
+
+	for (int i = mObjects.Size() - 1; i >= 0; i--)
+	{
+		LinkerObject* lobj = mObjects[i];
+		if (lobj->mFlags & LOBJF_PLACED)
+		{
+			int	start = lobj->mAddress < 0 ? 0 : lobj->mAddress, end = lobj->mAddress + lobj->mSize > 0x10000 ? 0x10000 : lobj->mAddress + lobj->mSize;
+			for (int j = start; j < end; j++)
+				mAddressObjects[j] = lobj;
+		}
+	}
+
+	for (int bank = 0; bank < 64; bank++)
+	{
+		int	start = 0x10000, end = 0;
+		for (int i = 0; i < mObjects.Size(); i++)
+		{
+			LinkerObject* lobj = mObjects[i];
+			if ((lobj->mFlags & LOBJF_PLACED) && lobj->mRegion && ((1ULL << bank) & lobj->mRegion->mCartridgeBanks) && lobj->mSize > 0)
+			{
+				if (lobj->mAddress < start)
+					start = lobj->mAddress;
+				if (lobj->mAddress + lobj->mSize > end)
+					end = lobj->mAddress + lobj->mSize;
+			}
+		}
+
+		mBankAddressStart[bank] = start;
+		mBankAddressObjects[bank].SetSize(end > start ? end - start : 0);
+		for (int j = start; j < end; j++)
+			mBankAddressObjects[bank][j - start] = nullptr;
+
+		for (int i = mObjects.Size() - 1; i >= 0; i--)
+		{
+			LinkerObject* lobj = mObjects[i];
+			if ((lobj->mFlags & LOBJF_PLACED) && lobj->mRegion && ((1ULL << bank) & lobj->mRegion->mCartridgeBanks))
+			{
+				for (int j = lobj->mAddress; j < lobj->mAddress + lobj->mSize; j++)
+					mBankAddressObjects[bank][j - start] = lobj;
+			}
+		}
+	}
+}
+
 LinkerObject* Linker::FindObjectByAddr(int addr)
 {
+	if (mAddressObjects.Size())
+		return addr >= 0 && addr < 0x10000 ? mAddressObjects[addr] : nullptr;
+
 	for (int i = 0; i < mObjects.Size(); i++)
 	{
 		LinkerObject* lobj = mObjects[i];
@@ -277,6 +331,18 @@ LinkerObject* Linker::FindObjectByAddr(int addr)
 
 LinkerObject* Linker::FindObjectByAddr(int bank, int addr)
 {
+	if (mAddressObjects.Size())
+	{
+		if (bank >= 0 && bank < 64)
+		{
+			int	offset = addr - mBankAddressStart[bank];
+			if (offset >= 0 && offset < mBankAddressObjects[bank].Size() && mBankAddressObjects[bank][offset])
+				return mBankAddressObjects[bank][offset];
+		}
+
+		return FindObjectByAddr(addr);
+	}
+
 	for (int i = 0; i < mObjects.Size(); i++)
 	{
 		LinkerObject* lobj = mObjects[i];
@@ -627,6 +693,54 @@ bool LinkerRegion::AllocateAppend(Linker* linker, LinkerObject* lobj)
 	return false;
 }
 
+static int CountLoopPageCrossings(const LinkerObject* lobj, int address)
+{
+	int	n = 0;
+	for (int i = 0; i < lobj->mLoops.Size(); i++)
+	{
+		int	s = address + lobj->mLoops[i].mOffset;
+		if ((s & 0xff00) != ((s + lobj->mLoops[i].mSize) & 0xff00))
+			n++;
+	}
+	return n;
+}
+
+int LinkerRegion::LoopPadding(Linker* linker, LinkerObject* lobj, int start, int end)
+{
+	// A taken branch into a different page costs an extra cycle, so pad
+	// the start of code with inner loops until as few back edges as
+	// possible cross a page, trading at most a few bytes per -O level
+
+	if (lobj->mLoops.Size() == 0 || !(linker->mCompilerOptions & COPT_OPTIMIZE_BASIC) || (linker->mCompilerOptions & COPT_OPTIMIZE_CODE_SIZE) || (lobj->mFlags & LOBJF_FORCE_ALIGN) || (lobj->mSection->mFlags & LSECF_PACKED))
+		return start;
+
+	int	maxpad = 4;
+	if (linker->mCompilerOptions & COPT_OPTIMIZE_AUTO_INLINE_ALL)
+		maxpad = 32;
+	else if (linker->mCompilerOptions & COPT_OPTIMIZE_AUTO_UNROLL)
+		maxpad = 16;
+
+	int	best = start, bestn = CountLoopPageCrossings(lobj, start + mReloc);
+	for (int pad = lobj->mAlignment; bestn > 0 && pad <= maxpad && start + pad + lobj->mSize <= end; pad += lobj->mAlignment)
+	{
+		int	n = CountLoopPageCrossings(lobj, start + pad + mReloc);
+		if (n < bestn)
+		{
+			best = start + pad;
+			bestn = n;
+		}
+	}
+
+	for (int i = 0; i < lobj->mLoops.Size(); i++)
+	{
+		LinkerObjectLoop& l(lobj->mLoops[i]);
+		int	s = start + mReloc + l.mOffset, b = best + mReloc + l.mOffset;
+		l.mAligned = (s & 0xff00) != ((s + l.mSize) & 0xff00) && (b & 0xff00) == ((b + l.mSize) & 0xff00);
+	}
+
+	return best;
+}
+
 bool LinkerRegion::Allocate(Linker * linker, LinkerObject* lobj, bool merge, bool retry)
 {
 	if (merge && lobj->mPrefix)
@@ -651,10 +765,20 @@ bool LinkerRegion::Allocate(Linker * linker, LinkerObject* lobj, bool merge, boo
 		int end = start + lobj->mSize;
 
 		if (!(linker->mCompilerOptions & COPT_OPTIMIZE_CODE_SIZE) && (lobj->mFlags & LOBJF_NO_CROSS) && lobj->mSize <= 256 && (start & 0xff00) != ((end - 1) & 0xff00) && !(lobj->mSection->mFlags & LSECF_PACKED))
-			;
-		else if (end <= mFreeChunks[i].mEnd)
 		{
-			if (merge && lobj->mPrefix && lobj->mPrefix == mFreeChunks[i].mLastObject)
+			// Try the next page start inside this chunk
+			start = (start + 0x00ff) & 0xff00;
+			end = start + lobj->mSize;
+		}
+		else if (!(merge && lobj->mPrefix && lobj->mPrefix == mFreeChunks[i].mLastObject))
+		{
+			start = LoopPadding(linker, lobj, start, mFreeChunks[i].mEnd);
+			end = start + lobj->mSize;
+		}
+
+		if (end <= mFreeChunks[i].mEnd)
+		{
+			if (merge && lobj->mPrefix && lobj->mPrefix == mFreeChunks[i].mLastObject && start == mFreeChunks[i].mStart)
 			{
 				lobj->mPrefix->mReferences[lobj->mPrefix->mSuffixReference]->mFlags = 0;
 				lobj->mPrefix->mSize -= 3;
@@ -707,11 +831,16 @@ bool LinkerRegion::Allocate(Linker * linker, LinkerObject* lobj, bool merge, boo
 		start = (start + 0x00ff) & 0xff00;
 		end = start + lobj->mSize;
 	}
+	else if (!retry && !(merge && lobj->mPrefix && lobj->mPrefix == mLastObject))
+	{
+		start = LoopPadding(linker, lobj, start, mEnd);
+		end = start + lobj->mSize;
+	}
 
 	if (end <= mEnd)
 	{
 		// Check if directly follows an object that jumps to this new object
-		if (merge && lobj->mPrefix && lobj->mPrefix == mLastObject)
+		if (merge && lobj->mPrefix && lobj->mPrefix == mLastObject && start == mStart + mUsed)
 		{
 			lobj->mPrefix->mReferences[lobj->mPrefix->mSuffixReference]->mFlags = 0;
 			lobj->mPrefix->mSize -= 3;
@@ -936,6 +1065,9 @@ void Linker::PatchReferences(bool inlays)
 				{
 					if (obj->mRegion->mCartridgeBanks)
 					{
+						if ((ref->mFlags & LREF_SELF_MODIFY) && !obj->mRegion->mReloc)
+							mErrors->Error(obj->mLocation, ERRR_SELF_MODIFYING_CODE_IN_ROM, "Self modifying code placed in cartridge ROM", obj->mIdent);
+
 						for (int i = 0; i < 64; i++)
 						{
 							if (obj->mRegion->mCartridgeBanks & (1ULL << i))
@@ -976,6 +1108,27 @@ void Linker::PatchReferences(bool inlays)
 	}
 }
 
+bool Linker::PlaceObject(LinkerRegion* lrgn, LinkerSection* lsec, LinkerObject* lobj, bool retry)
+{
+	if (lobj->mType != LOT_INLAY && (lobj->mFlags & LOBJF_REFERENCED) && !(lobj->mFlags & LOBJF_PLACED) && lrgn->Allocate(this, lobj, mCompilerOptions & COPT_OPTIMIZE_MERGE_CALLS, retry))
+	{
+		if (lobj->mIdent && lobj->mIdent->mString && (mCompilerOptions & COPT_VERBOSE2))
+			printf("Placed object <%s> $%04x - $%04x\n", lobj->mIdent->mString, lobj->mAddress, lobj->mAddress + lobj->mSize);
+
+		if (lobj->mAddress < lsec->mStart)
+			lsec->mStart = lobj->mAddress;
+		if (lobj->mAddress + lobj->mSize > lsec->mEnd)
+			lsec->mEnd = lobj->mAddress + lobj->mSize;
+
+		if (lsec->mType == LST_DATA && lsec->mEnd > lrgn->mNonzero)
+			lrgn->mNonzero = lsec->mEnd;
+
+		return true;
+	}
+	else
+		return false;
+}
+
 void Linker::PlaceObjects(bool retry)
 {
 	for (int i = 0; i < mRegions.Size(); i++)
@@ -985,20 +1138,215 @@ void Linker::PlaceObjects(bool retry)
 		{
 			LinkerSection* lsec = lrgn->mSections[j];
 			for (int k = 0; k < lsec->mObjects.Size(); k++)
+				PlaceObject(lrgn, lsec, lsec->mObjects[k], retry);
+		}
+	}
+}
+
+static bool IsDirectCall(LinkerObject* cobj, LinkerReference* ref)
+{
+	return
+		(ref->mFlags & (LREF_LOWBYTE | LREF_HIGHBYTE)) == (LREF_LOWBYTE | LREF_HIGHBYTE) &&
+		ref->mOffset > 0 && ref->mOffset + 2 <= cobj->mSize && ref->mRefOffset == 0 &&
+		ref->mRefObject != cobj && ref->mRefObject->mType == LOT_NATIVE_CODE &&
+		(cobj->mData[ref->mOffset - 1] == 0x20 || cobj->mData[ref->mOffset - 1] == 0x4c);
+}
+
+void Linker::PlaceBankedObjects(void)
+{
+	// Sections that live in cartridge banks only are placed first, so the bank of each
+	// function is known when building the trampolines.  A section spread over several
+	// banks is filled bank by bank, always picking the function with the most direct
+	// calls to and from the functions already in the current bank.
+
+	GrowingArray<int>	gain(0), tried(-1);
+
+	for (int i = 0; i < mSections.Size(); i++)
+	{
+		LinkerSection* lsec = mSections[i];
+
+		ExpandingArray<LinkerRegion*>	rgns;
+		bool	banked = true;
+		for (int j = 0; j < mRegions.Size(); j++)
+		{
+			if (mRegions[j]->mSections.Contains(lsec))
 			{
-				LinkerObject* lobj = lsec->mObjects[k];
-				if (lobj->mType != LOT_INLAY && (lobj->mFlags & LOBJF_REFERENCED) && !(lobj->mFlags & LOBJF_PLACED) && lrgn->Allocate(this, lobj, mCompilerOptions & COPT_OPTIMIZE_MERGE_CALLS, retry))
+				rgns.Push(mRegions[j]);
+				if (!mRegions[j]->mCartridgeBanks || mRegions[j]->mInlayObject)
+					banked = false;
+			}
+		}
+
+		if (banked && rgns.Size() > 0)
+		{
+			ExpandingArray<LinkerObject*>	calls;
+			if (rgns.Size() > 1)
+			{
+				for (int k = 0; k < lsec->mObjects.Size(); k++)
+				{
+					LinkerObject* cobj = lsec->mObjects[k];
+					if (cobj->mType == LOT_NATIVE_CODE && (cobj->mFlags & LOBJF_REFERENCED))
+					{
+						for (int l = 0; l < cobj->mReferences.Size(); l++)
+						{
+							LinkerReference* ref = cobj->mReferences[l];
+							if (IsDirectCall(cobj, ref) && ref->mRefObject->mSection == lsec)
+							{
+								calls.Push(cobj);
+								calls.Push(ref->mRefObject);
+							}
+						}
+					}
+				}
+			}
+
+			for (int j = 0; j < rgns.Size(); j++)
+			{
+				LinkerRegion* lrgn = rgns[j];
+
+				for (int k = 0; k < lsec->mObjects.Size(); k++)
+					gain[lsec->mObjects[k]->mID] = 0;
+
+				for (;;)
 				{
-					if (lobj->mIdent && lobj->mIdent->mString && (mCompilerOptions & COPT_VERBOSE2))
-						printf("Placed object <%s> $%04x - $%04x\n", lobj->mIdent->mString, lobj->mAddress, lobj->mAddress + lobj->mSize);
+					LinkerObject* bobj = nullptr;
+					for (int k = 0; k < lsec->mObjects.Size(); k++)
+					{
+						LinkerObject* lobj = lsec->mObjects[k];
+						if (lobj->mType != LOT_INLAY && (lobj->mFlags & LOBJF_REFERENCED) && !(lobj->mFlags & LOBJF_PLACED) && tried[lobj->mID] != j)
+						{
+							if (!bobj || gain[lobj->mID] > gain[bobj->mID])
+								bobj = lobj;
+						}
+					}
 
-					if (lobj->mAddress < lsec->mStart)
-						lsec->mStart = lobj->mAddress;
-					if (lobj->mAddress + lobj->mSize > lsec->mEnd)
-						lsec->mEnd = lobj->mAddress + lobj->mSize;
+					if (!bobj)
+						break;
 
-					if (lsec->mType == LST_DATA && lsec->mEnd > lrgn->mNonzero)
-						lrgn->mNonzero = lsec->mEnd;
+					if (PlaceObject(lrgn, lsec, bobj, false))
+					{
+						for (int k = 0; k < calls.Size(); k += 2)
+						{
+							if (calls[k] == bobj)
+								gain[calls[k + 1]->mID]++;
+							else if (calls[k + 1] == bobj)
+								gain[calls[k]->mID]++;
+						}
+					}
+					else
+						tried[bobj->mID] = j;
+				}
+			}
+		}
+	}
+}
+
+void Linker::BuildBankTrampolines(void)
+{
+	// Direct calls into a bank, that is not mapped when the caller runs, are
+	// redirected to a trampoline in the shared code section, that switches to
+	// the bank of the callee and back to the previous bank on return.  The
+	// current bank is tracked in a shadow byte, as the bank register can not
+	// be read back.  The accu is passed through unchanged in both directions.
+
+	static const uint8 trampoline[] = {
+		0x8d, 0x00, 0x00,		// sta tmp
+		0xad, 0x00, 0x00,		// lda shadow
+		0x48,					// pha
+		0xa9, 0x00,				// lda #bank
+		0x8d, 0x00, 0x00,		// sta shadow
+		0x8d, 0x00, 0xde,		// sta $de00
+		0xad, 0x00, 0x00,		// lda tmp
+		0x20, 0x00, 0x00,		// jsr callee
+		0x8d, 0x00, 0x00,		// sta tmp
+		0x68,					// pla
+		0x8d, 0x00, 0x00,		// sta shadow
+		0x8d, 0x00, 0xde,		// sta $de00
+		0xad, 0x00, 0x00,		// lda tmp
+		0x60					// rts
+	};
+
+	static const int trampolineRefs[][2] = {
+		{ 1, 1 }, { 4, 0 }, { 10, 0 }, { 16, 1 }, { 19, -1 }, { 22, 1 }, { 26, 0 }, { 32, 1 }
+	};
+
+	LinkerSection* csec = FindSection(Ident::Unique("code"));
+	LinkerSection* dsec = FindSection(Ident::Unique("data"));
+	LinkerRegion* crgn = csec ? FindRegionOfSection(csec) : nullptr;
+	LinkerRegion* drgn = dsec ? FindRegionOfSection(dsec) : nullptr;
+
+	LinkerObject* sobj = nullptr;
+	GrowingArray<LinkerObject*>	tobjs(nullptr);
+
+	int	n = mObjects.Size();
+	for (int i = 0; i < n; i++)
+	{
+		LinkerObject* cobj = mObjects[i];
+		if (cobj->mType == LOT_NATIVE_CODE && (cobj->mFlags & LOBJF_REFERENCED))
+		{
+			LinkerRegion* rrgn = cobj->mRegion ? cobj->mRegion : FindRegionOfSection(cobj->mSection);
+			uint64	cbanks = rrgn ? rrgn->mCartridgeBanks : 0;
+
+			for (int j = 0; j < cobj->mReferences.Size(); j++)
+			{
+				LinkerReference* ref = cobj->mReferences[j];
+				if (IsDirectCall(cobj, ref))
+				{
+					LinkerObject* fobj = ref->mRefObject;
+					if (fobj->mRegion && fobj->mRegion->mCartridgeBanks && (!cbanks || (cbanks & ~fobj->mRegion->mCartridgeBanks)))
+					{
+						if (!crgn || crgn->mCartridgeBanks || !drgn || drgn->mCartridgeBanks)
+						{
+							mErrors->Error(cobj->mLocation, ERRR_CROSS_BANK_CALL, "No shared code and data region for cross bank call", fobj->mIdent);
+							return;
+						}
+
+						if (!sobj)
+						{
+							sobj = AddObject(cobj->mLocation, Ident::Unique("bank_shadow"), dsec, LOT_DATA);
+							sobj->AddSpace(2);
+							sobj->mFlags |= LOBJF_REFERENCED;
+						}
+
+						LinkerObject* tobj = tobjs[fobj->mID];
+						if (!tobj)
+						{
+							char	tname[200];
+							sprintf_s(tname, "%s@bank", fobj->mIdent ? fobj->mIdent->mString : "");
+
+							tobj = AddObject(fobj->mLocation, Ident::Unique(tname), csec, LOT_NATIVE_CODE);
+							tobj->AddData(trampoline, sizeof(trampoline));
+							tobj->mData[8] = fobj->FirstBank() - 1;
+							tobj->mFlags |= LOBJF_REFERENCED;
+
+							for (int k = 0; k < sizeof(trampolineRefs) / sizeof(trampolineRefs[0]); k++)
+							{
+								LinkerReference	tref;
+								tref.mObject = tobj;
+								tref.mOffset = trampolineRefs[k][0];
+								tref.mFlags = LREF_LOWBYTE | LREF_HIGHBYTE;
+								if (trampolineRefs[k][1] < 0)
+								{
+									tref.mRefObject = fobj;
+									tref.mRefOffset = 0;
+								}
+								else
+								{
+									tref.mRefObject = sobj;
+									tref.mRefOffset = trampolineRefs[k][1];
+								}
+								tobj->AddReference(tref);
+								mReferences.Push(tobj->mReferences.Last());
+							}
+
+							tobjs[fobj->mID] = tobj;
+
+							if (mCompilerOptions & COPT_VERBOSE2)
+								printf("Bank trampoline <%s> for bank %d\n", tname, fobj->FirstBank() - 1);
+						}
+
+						ref->mRefObject = tobj;
+					}
 				}
 			}
 		}
@@ -1037,6 +1385,8 @@ void Linker::SortObjects(void)
 
 void Linker::Link(void)
 {
+	mAddressObjects.SetSize(0);
+
 	if (mErrors->mErrorCount == 0)
 	{
 
@@ -1047,6 +1397,12 @@ void Linker::Link(void)
 			lsec->mEnd = 0x0000;
 		}
 
+		if ((mCompilerOptions & COPT_BANK_TRAMPOLINES) && (mCompilerOptions & COPT_TARGET_CRT_EASYFLASH))
+		{
+			PlaceBankedObjects();
+			BuildBankTrampolines();
+		}
+
 		// Move objects into regions
 		PlaceObjects(false);
 
@@ -1672,6 +2028,7 @@ bool Linker::WriteMapFile(const char* filename)
 	fopen_s(&file, filename, "wb");
 	if (file)
 	{
+		setvbuf(file, nullptr, _IOFBF, 0x10000);
 		fprintf(file, "sections\n");
 		for (int i = 0; i <  mSections.Size(); i++)
 		{
@@ -1718,6 +2075,36 @@ bool Linker::WriteMapFile(const char* filename)
 			}
 		}
 
+		fprintf(file, "\nloops\n");
+
+		int	nsaved = 0;
+		for (int i = 0; i < mObjects.Size(); i++)
+		{
+			LinkerObject* obj = mObjects[i];
+
+			if ((obj->mFlags & LOBJF_REFERENCED) && (obj->mFlags & LOBJF_PLACED) && obj->mIdent)
+			{
+				for (int j = 0; j < obj->mLoops.Size(); j++)
+				{
+					const LinkerObjectLoop& l(obj->mLoops[j]);
+					int	s = obj->mRefAddress + l.mOffset;
+
+					fprintf(file, "%04x - %04x : %s.%s, ", obj->mAddress + l.mOffset, obj->mAddress + l.mOffset + l.mSize, obj->mIdent->mString, l.mIdent->mString);
+					if ((s & 0xff00) != ((s + l.mSize) & 0xff00))
+						fprintf(file, "page crossing, +1 cycle per iteration\n");
+					else if (l.mAligned)
+					{
+						fprintf(file, "aligned, -1 cycle per iteration\n");
+						nsaved++;
+					}
+					else
+						fprintf(file, "same page\n");
+				}
+			}
+		}
+
+		fprintf(file, "%d loops aligned\n", nsaved);
+
 		if (banked)
 		{
 			fprintf(file, "\nbanks\n");
@@ -1805,6 +2192,7 @@ bool Linker::WriteMlbFile(const char* filename, TargetMachine machine)
 	fopen_s(&file, filename, "wb");
 	if (file)
 	{
+		setvbuf(file, nullptr, _IOFBF, 0x10000);
 		fprintf(file, "R:%02x-%02x:__ACCU\n", BC_REG_ACCU, BC_REG_ACCU + 3);
 		fprintf(file, "R:%02x-%02x:__ADDR\n", BC_REG_ADDR, BC_REG_ADDR + 1);
 		fprintf(file, "R:%02x-%02x:__IP\n", BC_REG_IP, BC_REG_IP + 1);
@@ -1909,6 +2297,7 @@ bool Linker::WriteLblFile(const char* filename)
 	fopen_s(&file, filename, "wb");
 	if (file)
 	{
+		setvbuf(file, nullptr, _IOFBF, 0x10000);
 		for (int i = 0; i < mObjects.Size(); i++)
 		{
 			LinkerObject* obj = mObjects[i];
@@ -1939,6 +2328,7 @@ bool Linker::WriteAsmFile(const char* filename, const char* version)
 	fopen_s(&file, filename, "wb");
 	if (file)
 	{
+		setvbuf(file, nullptr, _IOFBF, 0x10000);
 		fprintf(file, "; Compiled with %s\n", version);
 
 		for (int i = 0; i < mObjects.Size(); i++)
@@ -102,6 +102,7 @@ public:
 	
 	bool AllocateAppend(Linker* linker, LinkerObject* obj);
 	bool Allocate(Linker * linker, LinkerObject* obj, bool merge, bool retry);
+	int LoopPadding(Linker* linker, LinkerObject* obj, int start, int end);
 	void PlaceStackSection(LinkerSection* stackSection, LinkerSection* section);
 };
 
@@ -111,6 +112,7 @@ static const uint32 LREF_TEMPORARY		=	0x00000004;
 static const uint32 LREF_INBLOCK		=	0x00000008;
 static const uint32	LREF_LOWBYTE_OFFSET	=	0x00000010;
 static const uint32 LREF_BREAKPOINT		=	0x00000020;
+static const uint32 LREF_SELF_MODIFY	=	0x00000040;
 
 class LinkerReference
 {
@@ -174,6 +176,14 @@ public:
 	int				mOffset, mSize;
 };
 
+class LinkerObjectLoop
+{
+public:
+	const Ident	*	mIdent;
+	int				mOffset, mSize;	// From loop head to the instruction following the back edge branch
+	bool			mAligned;		// Padding moved the back edge branch off a page crossing
+};
+
 struct CodeLocation
 {
 	Location	mLocation;
@@ -208,6 +218,7 @@ public:
 	ExpandingArray<LinkerObjectRange>	mRanges;
 	ExpandingArray<CodeLocation>		mCodeLocations;
 	ExpandingArray<LinkerObjectRange>	mZeroPageRanges;
+	ExpandingArray<LinkerObjectLoop>	mLoops;
 
 	LinkerObject(void);
 	~LinkerObject(void);
@@ -262,6 +273,7 @@ public:
 
 	LinkerObject* FindObjectByAddr(int addr);
 	LinkerObject* FindObjectByAddr(int bank, int addr);
+	void BuildAddressTable(void);
 
 	bool IsSectionPlaced(LinkerSection* section);
 
@@ -306,6 +318,10 @@ public:
 
 	int	mProgramStart, mProgramEnd;
 
+	// Placed objects by address for the symbolic listings, built after linking
+	ExpandingArray<LinkerObject*>	mAddressObjects, mBankAddressObjects[64];
+	int								mBankAddressStart[64];
+
 	void ReferenceObject(LinkerObject* obj);
 	
 	void CheckDirectJumps(void);
@@ -315,13 +331,17 @@ public:
 	void PatchReferences(bool inlays);
 	void CopyObjects(bool inlays);
 	void PlaceObjects(bool retry);
+	void PlaceBankedObjects(void);
+	void BuildBankTrampolines(void);
 	void Link(void);
 	void CollectBreakpoints(void);
+
+	ByteCodeDisassembler	mByteCodeDisassembler;
 protected:
 	NativeCodeDisassembler	mNativeDisassembler;
-	ByteCodeDisassembler	mByteCodeDisassembler;
 
 	bool Forwards(LinkerObject* pobj, LinkerObject* lobj);
+	bool PlaceObject(LinkerRegion* lrgn, LinkerSection* lsec, LinkerObject* lobj, bool retry);
 	void SortObjectsPartition(int l, int r);
 
 	Errors* mErrors;
@@ -27,6 +27,7 @@ static const uint32 LIVE_CPU_REG_Z = 0x00000010;
 static const uint32 LIVE_CPU_REG   = 0x0000001f;
 
 static const uint32 LIVE_MEM	   = 0x00000020;
+static const uint32 LIVE_CPU_REG_V = 0x00000040;
 
 static const uint32 LIVE_ALL	   = 0x000000ff;
 
@@ -603,6 +604,9 @@ void NativeCodeInstruction::Disassemble(FILE* file) const
 	case ASMIM_INDIRECT_Y:
 		fprintf(file, "%s (%s), y", AsmInstructionNames[mType], AddrName(buffer));
 		break;
+	case ASMIM_ZERO_PAGE_INDIRECT:
+		fprintf(file, "%s (%s)", AsmInstructionNames[mType], AddrName(buffer));
+		break;
 	case ASMIM_RELATIVE:
 		fprintf(file, "%s %d", AsmInstructionNames[mType], mAddress);
 		break;
@@ -702,7 +706,11 @@ bool NativeCodeInstruction::IsUsedResultInstructions(NumberSet& requiredTemps)
 	{
 #if 1
 		if (mFlags & NCIF_USE_CPU_REG_A)
+		{
 			requiredTemps += CPU_REG_A;
+			if (mFlags & NCIF_USE_CPU_REG_X)
+				requiredTemps += CPU_REG_X;
+		}
 		else if (mFlags & NCIF_LOWER)
 		{
 			requiredTemps += BC_REG_ACCU;
@@ -1131,6 +1139,8 @@ bool NativeCodeInstruction::RequiresYReg(void) const
 		return true;
 	if (mType == ASMIT_TYA || mType == ASMIT_STY || mType == ASMIT_CPY || mType == ASMIT_INY || mType == ASMIT_DEY)
 		return true;
+	if (mType == ASMIT_JSR && (mFlags & NCIF_USE_CPU_REG_Y))
+		return true;
 
 	return false;
 }
@@ -1141,6 +1151,8 @@ bool NativeCodeInstruction::RequiresXReg(void) const
 		return true;
 	if (mType == ASMIT_TXA || mType == ASMIT_STX || mType == ASMIT_CPX || mType == ASMIT_INX || mType == ASMIT_DEX)
 		return true;
+	if ((mType == ASMIT_JSR || mType == ASMIT_RTS) && (mFlags & NCIF_USE_CPU_REG_X))
+		return true;
 
 	return false;
 }
@@ -1203,7 +1215,9 @@ bool NativeCodeInstruction::CanSwapXYReg(void)
 		return mType == ASMIT_LDY || HasAsmInstructionMode(mType, ASMIM_ABSOLUTE_Y);
 	else if (mMode == ASMIM_ABSOLUTE_Y)
 		return mType == ASMIT_LDX || HasAsmInstructionMode(mType, ASMIM_ABSOLUTE_X);
-	else if (mType == ASMIT_JSR && (mFlags & (NCIF_USE_CPU_REG_X | NCIF_USE_CPU_REG_Y)))
+	else if ((mType == ASMIT_JSR || mType == ASMIT_RTS) && (mFlags & (NCIF_USE_CPU_REG_X | NCIF_USE_CPU_REG_Y)))
+		return false;
+	else if (mType == ASMIT_JSR && mLinkerObject && (mLinkerObject->mFlags & LOBJF_RET_REG_X))
 		return false;
 	else
 		return true;
@@ -4793,6 +4807,11 @@ void NativeCodeInstruction::FilterRegUsage(NumberSet& requiredTemps, NumberSet&
 			if (!providedTemps[CPU_REG_A])
 				requiredTemps += CPU_REG_A;
 		}
+		if (mFlags & NCIF_USE_CPU_REG_X)
+		{
+			if (!providedTemps[CPU_REG_X])
+				requiredTemps += CPU_REG_X;
+		}
 
 		if (mFlags & NCIF_LOWER)
 		{
@@ -5128,6 +5147,28 @@ void NativeCodeInstruction::Assemble(NativeCodeBasicBlock* block)
 			}
 		}
 	}
+	else if (mFlags & NCIF_SELF_MODIFIED)
+	{
+		block->PutOpcode(AsmInsOpcodes[mType][mMode]);
+		block->mProc->mPatchBlocks[mParam] = block;
+		block->mProc->mPatchOffsets[mParam] = block->mCode.Size();
+		block->PutWord(0);
+	}
+	else if (mFlags & NCIF_SELF_PATCH)
+	{
+		block->PutOpcode(AsmInsOpcodes[mType][ASMIM_ABSOLUTE]);
+
+		// Resolved by the procedure once the patched block is placed
+
+		LinkerReference		rl;
+		rl.mOffset = block->mCode.Size();
+		rl.mRefObject = nullptr;
+		rl.mRefOffset = 2 * mParam + mAddress;
+		rl.mFlags = LREF_LOWBYTE | LREF_HIGHBYTE | LREF_SELF_MODIFY;
+
+		block->mRelocations.Push(rl);
+		block->PutWord(0);
+	}
 	else
 	{
 		if ((mType == ASMIT_JSR || mType == ASMIT_JMP) && (mFlags & NCIF_USE_ZP_32_X))
@@ -5172,6 +5213,7 @@ void NativeCodeInstruction::Assemble(NativeCodeBasicBlock* block)
 		case ASMIM_ZERO_PAGE_Y:
 		case ASMIM_INDIRECT_X:
 		case ASMIM_INDIRECT_Y:
+		case ASMIM_ZERO_PAGE_INDIRECT:
 			if (mLinkerObject)
 			{
 				LinkerReference		rl;
@@ -5404,6 +5446,12 @@ int NativeCodeBasicBlock::PutJump(NativeCodeProcedure* proc, NativeCodeBasicBloc
 			return 2;
 		}
 #endif
+		else if (mProc->mGenerator->mCompilerOptions & COPT_CPU_65C02)
+		{
+			PutOpcode(AsmInsOpcodes[ASMIT_BRA][ASMIM_RELATIVE]);
+			PutByte(to - from - 2);
+			return 2;
+		}
 	}
 
 	target->mAsmFromJump = from;
@@ -5469,6 +5517,8 @@ int NativeCodeBasicBlock::JumpByteSize(NativeCodeBasicBlock* target, int from, i
 		else if (mNDataSet.mRegs[CPU_REG_Z].mMode == NRDM_IMMEDIATE)
 			return 2;
 #endif
+		else if (mProc->mGenerator->mCompilerOptions & COPT_CPU_65C02)
+			return 2;
 		else
 		{
 			if (final)
@@ -8365,6 +8415,13 @@ NativeCodeBasicBlock * NativeCodeBasicBlock::CopyValue(InterCodeProcedure* proc,
 			lblock->mIns.Push(NativeCodeInstruction(ins, ASMIT_LDA, ASMIM_INDIRECT_Y, sreg, nullptr, flags));
 			lblock->mIns.Push(NativeCodeInstruction(ins, ASMIT_STA, ASMIM_INDIRECT_Y, dreg, nullptr, flags));
 			lblock->mIns.Push(NativeCodeInstruction(ins, ASMIT_INY, ASMIM_IMPLIED));
+			if (nproc->mCompilerOptions & COPT_OPTIMIZE_AUTO_UNROLL)
+			{
+				// Two bytes per iteration, a page is always an even number of bytes
+				lblock->mIns.Push(NativeCodeInstruction(ins, ASMIT_LDA, ASMIM_INDIRECT_Y, sreg, nullptr, flags));
+				lblock->mIns.Push(NativeCodeInstruction(ins, ASMIT_STA, ASMIM_INDIRECT_Y, dreg, nullptr, flags));
+				lblock->mIns.Push(NativeCodeInstruction(ins, ASMIT_INY, ASMIM_IMPLIED));
+			}
 			lblock->Close(ins, lblock, lblock2, ASMIT_BNE);
 			lblock2->mIns.Push(NativeCodeInstruction(ins, ASMIT_INC, ASMIM_ZERO_PAGE, sreg + 1));
 			lblock2->mIns.Push(NativeCodeInstruction(ins, ASMIT_INC, ASMIM_ZERO_PAGE, dreg + 1));
@@ -8719,6 +8776,11 @@ NativeCodeBasicBlock* NativeCodeBasicBlock::FillValue(InterCodeProcedure* proc,
 			this->Close(ins, lblock, nullptr, ASMIT_JMP);
 			lblock->mIns.Push(NativeCodeInstruction(ins, ASMIT_STA, ASMIM_INDIRECT_Y, dreg, nullptr, flags));
 			lblock->mIns.Push(NativeCodeInstruction(ins, ASMIT_INY, ASMIM_IMPLIED));
+			if (nproc->mCompilerOptions & COPT_OPTIMIZE_AUTO_UNROLL)
+			{
+				lblock->mIns.Push(NativeCodeInstruction(ins, ASMIT_STA, ASMIM_INDIRECT_Y, dreg, nullptr, flags));
+				lblock->mIns.Push(NativeCodeInstruction(ins, ASMIT_INY, ASMIM_IMPLIED));
+			}
 			lblock->Close(ins, lblock, lblock2, ASMIT_BNE);
 			lblock2->mIns.Push(NativeCodeInstruction(ins, ASMIT_INC, ASMIM_ZERO_PAGE, dreg + 1));
 			if (size >= 512)
@@ -8759,23 +8821,41 @@ NativeCodeBasicBlock* NativeCodeBasicBlock::FillValue(InterCodeProcedure* proc,
 
 void NativeCodeBasicBlock::CallMalloc(InterCodeProcedure* proc, const InterInstruction* ins, NativeCodeProcedure* nproc)
 {
-	if (ins->mSrc[0].mTemp < 0)
+	if (ins->mSrc[0].mTemp < 0 && ins->mSrc[0].mIntConst >= 0 && ins->mSrc[0].mIntConst <= 30 && nproc->mGenerator->HasRuntime(Ident::Unique("mallocslab0")))
 	{
-		mIns.Push(NativeCodeInstruction(ins, ASMIT_LDA, ASMIM_IMMEDIATE, ins->mSrc[0].mIntConst & 0xff));
-		mIns.Push(NativeCodeInstruction(ins, ASMIT_STA, ASMIM_ZERO_PAGE, BC_REG_ACCU + 0));
-		mIns.Push(NativeCodeInstruction(ins, ASMIT_LDA, ASMIM_IMMEDIATE, (ins->mSrc[0].mIntConst >> 8) & 0xff));
-		mIns.Push(NativeCodeInstruction(ins, ASMIT_STA, ASMIM_ZERO_PAGE, BC_REG_ACCU + 1));
+		// Constant small size with slab allocator, select the size class at compile time
+
+		const Ident* ident;
+		if (ins->mSrc[0].mIntConst <= 6)
+			ident = Ident::Unique("mallocslab0");
+		else if (ins->mSrc[0].mIntConst <= 14)
+			ident = Ident::Unique("mallocslab1");
+		else
+			ident = Ident::Unique("mallocslab2");
+
+		NativeCodeGenerator::Runtime& frt(nproc->mGenerator->ResolveRuntime(ident));
+		mIns.Push(NativeCodeInstruction(ins, ASMIT_JSR, ASMIM_ABSOLUTE, frt.mOffset, frt.mLinkerObject, NCIF_RUNTIME | NCIF_LOWER | NCIF_UPPER));
 	}
 	else
 	{
-		mIns.Push(NativeCodeInstruction(ins, ASMIT_LDA, ASMIM_ZERO_PAGE, BC_REG_TMP + proc->mTempOffset[ins->mSrc[0].mTemp] + 0));
-		mIns.Push(NativeCodeInstruction(ins, ASMIT_STA, ASMIM_ZERO_PAGE, BC_REG_ACCU + 0));
-		mIns.Push(NativeCodeInstruction(ins, ASMIT_LDA, ASMIM_ZERO_PAGE, BC_REG_TMP + proc->mTempOffset[ins->mSrc[0].mTemp] + 1));
-		mIns.Push(NativeCodeInstruction(ins, ASMIT_STA, ASMIM_ZERO_PAGE, BC_REG_ACCU + 1));
-	}
+		if (ins->mSrc[0].mTemp < 0)
+		{
+			mIns.Push(NativeCodeInstruction(ins, ASMIT_LDA, ASMIM_IMMEDIATE, ins->mSrc[0].mIntConst & 0xff));
+			mIns.Push(NativeCodeInstruction(ins, ASMIT_STA, ASMIM_ZERO_PAGE, BC_REG_ACCU + 0));
+			mIns.Push(NativeCodeInstruction(ins, ASMIT_LDA, ASMIM_IMMEDIATE, (ins->mSrc[0].mIntConst >> 8) & 0xff));
+			mIns.Push(NativeCodeInstruction(ins, ASMIT_STA, ASMIM_ZERO_PAGE, BC_REG_ACCU + 1));
+		}
+		else
+		{
+			mIns.Push(NativeCodeInstruction(ins, ASMIT_LDA, ASMIM_ZERO_PAGE, BC_REG_TMP + proc->mTempOffset[ins->mSrc[0].mTemp] + 0));
+			mIns.Push(NativeCodeInstruction(ins, ASMIT_STA, ASMIM_ZERO_PAGE, BC_REG_ACCU + 0));
+			mIns.Push(NativeCodeInstruction(ins, ASMIT_LDA, ASMIM_ZERO_PAGE, BC_REG_TMP + proc->mTempOffset[ins->mSrc[0].mTemp] + 1));
+			mIns.Push(NativeCodeInstruction(ins, ASMIT_STA, ASMIM_ZERO_PAGE, BC_REG_ACCU + 1));
+		}
 
-	NativeCodeGenerator::Runtime& frt(nproc->mGenerator->ResolveRuntime(Ident::Unique("malloc")));
-	mIns.Push(NativeCodeInstruction(ins, ASMIT_JSR, ASMIM_ABSOLUTE, frt.mOffset, frt.mLinkerObject, NCIF_RUNTIME | NCIF_LOWER | NCIF_UPPER));
+		NativeCodeGenerator::Runtime& frt(nproc->mGenerator->ResolveRuntime(Ident::Unique("malloc")));
+		mIns.Push(NativeCodeInstruction(ins, ASMIT_JSR, ASMIM_ABSOLUTE, frt.mOffset, frt.mLinkerObject, NCIF_RUNTIME | NCIF_LOWER | NCIF_UPPER));
+	}
 
 	if (ins->mDst.mTemp >= 0)
 	{
@@ -14232,6 +14312,7 @@ NativeCodeInstruction NativeCodeBasicBlock::DecodeNative(const InterInstruction*
 	case ASMIM_ZERO_PAGE_Y:
 	case ASMIM_INDIRECT_X:
 	case ASMIM_INDIRECT_Y:
+	case ASMIM_ZERO_PAGE_INDIRECT:
 		lref = lobj->FindReference(offset);
 		address = lobj->mData[offset++];
 		if (lref && (lref->mFlags & LREF_TEMPORARY))
@@ -14306,15 +14387,29 @@ void NativeCodeBasicBlock::CallAssembler(InterCodeProcedure* proc, NativeCodePro
 	if (ins->mSrc[0].mTemp < 0)
 	{
 		uint32	flags = NCIF_LOWER | NCIF_UPPER;
+
+		// Register arguments are the first parameter bytes of the callee, load them
+		// from the parameter registers the arguments were stored into
+
+		int		preg = BC_REG_FPARAMS;
+		if (ins->mSrc[0].mLinkerObject->mProc)
+			preg += ins->mSrc[0].mLinkerObject->mProc->mFastCallBase;
+
 		if (ins->mSrc[0].mLinkerObject->mFlags & LOBJF_ARG_REG_A)
 		{
 			flags |= NCIF_USE_CPU_REG_A;
-			mIns.Push(NativeCodeInstruction(ins, ASMIT_LDA, ASMIM_ZERO_PAGE, BC_REG_FPARAMS));
+			mIns.Push(NativeCodeInstruction(ins, ASMIT_LDA, ASMIM_ZERO_PAGE, preg + 0));
 		}
 		if (ins->mSrc[0].mLinkerObject->mFlags & LOBJF_ARG_REG_X)
+		{
 			flags |= NCIF_USE_CPU_REG_X;
+			mIns.Push(NativeCodeInstruction(ins, ASMIT_LDX, ASMIM_ZERO_PAGE, preg + 1));
+		}
 		if (ins->mSrc[0].mLinkerObject->mFlags & LOBJF_ARG_REG_Y)
+		{
 			flags |= NCIF_USE_CPU_REG_Y;
+			mIns.Push(NativeCodeInstruction(ins, ASMIT_LDY, ASMIM_ZERO_PAGE, preg + 2));
+		}
 
 		assert(ins->mSrc[0].mLinkerObject);
 
@@ -14340,6 +14435,7 @@ void NativeCodeBasicBlock::CallAssembler(InterCodeProcedure* proc, NativeCodePro
 				}
 
 				if (dins.mType == ASMIT_BRK || dins.mMode == ASMIM_INDIRECT_X || dins.mMode == ASMIM_INDIRECT || 
+					dins.mType > ASMIT_TYA || dins.mMode == ASMIM_ZERO_PAGE_INDIRECT || dins.mMode == ASMIM_IMPLIED && (dins.mType == ASMIT_INC || dins.mType == ASMIT_DEC) ||
 					dins.mType == ASMIT_SEI || dins.mType == ASMIT_CLI || dins.mType == ASMIT_SED || dins.mType == ASMIT_CLD ||
 					dins.mType == ASMIT_RTI || dins.mType == ASMIT_TXS || dins.mType == ASMIT_TSX ||
 					dins.mType == ASMIT_PHP || dins.mType == ASMIT_PLP || dins.mType == ASMIT_PHA || dins.mType == ASMIT_PLA)
@@ -14630,51 +14726,6 @@ void NativeCodeBasicBlock::BuildCollisionTable(NumberSet* collisionSets)
 	}
 }
 
-void NativeCodeBasicBlock::BuildDominatorTree(NativeCodeBasicBlock* from, DominatorStacks& stacks)
-{
-	if (from == this)
-		return;
-	else if (!mDominator)
-		mDominator = from;
-	else if (from == mDominator)
-		return;
-	else
-	{
-		stacks.d1.SetSize(0);
-		stacks.d2.SetSize(0);
-
-		NativeCodeBasicBlock* b = mDominator;
-		while (b)
-		{
-			stacks.d1.Push(b);
-			b = b->mDominator;
-		}
-		b = from;
-		while (b)
-		{
-			stacks.d2.Push(b);
-			b = b->mDominator;
-		}
-
-		b = nullptr;
-		while (stacks.d1.Size() > 0 && stacks.d2.Size() > 0 && stacks.d1.Last() == stacks.d2.Last())
-		{
-			b = stacks.d1.Pop(); stacks.d2.Pop();
-		}
-
-		if (mDominator == b)
-			return;
-
-		mDominator = b;
-	}
-
-	if (mTrueJump)
-		mTrueJump->BuildDominatorTree(this, stacks);
-	if (mFalseJump)
-		mFalseJump->BuildDominatorTree(this, stacks);
-}
-
-
 void NativeCodeBasicBlock::CountEntries(NativeCodeBasicBlock * fromJump)
 {
 	if (mVisiting)
@@ -15231,6 +15282,96 @@ void NativeCodeBasicBlock::FindZeroPageAlias(const NumberSet& statics, NumberSet
 	}
 }
 
+static bool CollectAssemblerZeroPageSet(LinkerObject* lo, ZeroPageSet& set, ExpandingArray<LinkerObject*>& visited)
+{
+	// Zero page bytes changed by an assembler object and the assembler
+	// objects it calls or jumps to, fails if a target or an indexed
+	// zero page store can not be resolved
+
+	if (visited.Contains(lo))
+		return true;
+	visited.Push(lo);
+
+	if (!lo->mData || lo->mType != LOT_NATIVE_CODE)
+		return false;
+
+	for (int i = 0; i < lo->mNumTemporaries; i++)
+	{
+		for (int j = 0; j < lo->mTempSizes[i]; j++)
+			set += lo->mTemporaries[i] + j;
+	}
+
+	int	i = 0;
+	while (i < lo->mSize)
+	{
+		const AsmInsData& d = DecInsData[lo->mData[i]];
+		if (d.mType == ASMIT_INV)
+			return false;
+
+		int	n = AsmInsModeSize[d.mMode];
+		if (i + n > lo->mSize)
+			return false;
+
+		switch (d.mType)
+		{
+		case ASMIT_JSR:
+		case ASMIT_JMP:
+			if (d.mMode == ASMIM_ABSOLUTE)
+			{
+				LinkerReference* ref = lo->FindReference(i + 1);
+				if (ref && ref->mOffset == i + 1 && ref->mRefObject != lo)
+				{
+					LinkerObject* rlo = ref->mRefObject;
+					if (rlo->mFlags & LOBJF_ZEROPAGESET)
+						set |= rlo->mZeroPageSet;
+					else if (rlo->mProc || !CollectAssemblerZeroPageSet(rlo, set, visited))
+						return false;
+				}
+			}
+			else
+				return false;
+			break;
+
+		case ASMIT_STA:
+		case ASMIT_STX:
+		case ASMIT_STY:
+		case ASMIT_STZ:
+		case ASMIT_INC:
+		case ASMIT_DEC:
+		case ASMIT_ASL:
+		case ASMIT_LSR:
+		case ASMIT_ROL:
+		case ASMIT_ROR:
+		case ASMIT_TRB:
+		case ASMIT_TSB:
+		case ASMIT_DCP:
+		case ASMIT_ISC:
+		case ASMIT_SAX:
+			if (d.mMode == ASMIM_ZERO_PAGE)
+			{
+				if (!lo->FindReference(i + 1))
+					set += lo->mData[i + 1];
+			}
+			else if (d.mMode == ASMIM_ZERO_PAGE_X || d.mMode == ASMIM_ZERO_PAGE_Y)
+				return false;
+			else if (d.mMode == ASMIM_ABSOLUTE || d.mMode == ASMIM_ABSOLUTE_X || d.mMode == ASMIM_ABSOLUTE_Y)
+			{
+				if (!lo->FindReference(i + 1) && lo->mData[i + 2] == 0)
+				{
+					if (d.mMode != ASMIM_ABSOLUTE)
+						return false;
+					set += lo->mData[i + 1];
+				}
+			}
+			break;
+		}
+
+		i += n;
+	}
+
+	return true;
+}
+
 bool NativeCodeBasicBlock::CollectZeroPageSet(ZeroPageSet& locals, ZeroPageSet& global, bool ignorefcall)
 {
 	if (!mVisited)
@@ -15246,8 +15387,10 @@ bool NativeCodeBasicBlock::CollectZeroPageSet(ZeroPageSet& locals, ZeroPageSet&
 					locals += mIns[i].mAddress;
 				break;
 			case ASMIM_ABSOLUTE:
-				if (mIns[i].mType == ASMIT_JSR)
+				if (mIns[i].mType == ASMIT_JSR || mIns[i].mType == ASMIT_JMP && mIns[i].mLinkerObject && mIns[i].mLinkerObject->mType == LOT_NATIVE_CODE)
 				{
+					LinkerObject* lo = mIns[i].mLinkerObject;
+
 					if (mIns[i].mFlags & NCIF_RUNTIME)
 					{
 						if (mIns[i].mFlags & NCIF_FEXEC)
@@ -15257,17 +15400,27 @@ bool NativeCodeBasicBlock::CollectZeroPageSet(ZeroPageSet& locals, ZeroPageSet&
 						}
 						else
 						{
-							for (int j = 0; j < 4; j++)
+							// Scan the runtime code for its stores, and assume
+							// the complete work area if that is not possible
+
+							ExpandingArray<LinkerObject*>	visited;
+							if (!lo || !CollectAssemblerZeroPageSet(lo, locals, visited))
 							{
-								locals += BC_REG_ACCU + j;
-								locals += BC_REG_WORK + j;
+								for (int j = 0; j < 4; j++)
+									locals += BC_REG_ACCU + j;
+								for (int j = 0; j < 8; j++)
+									locals += BC_REG_WORK + j;
+								locals += BC_REG_WORK_Y;
+								locals += BC_REG_ADDR;
+								locals += BC_REG_ADDR + 1;
 							}
+							lo = nullptr;
 						}
 					}
 
-					if (mIns[i].mLinkerObject)
+					if (lo)
 					{
-						LinkerObject* lo = mIns[i].mLinkerObject;
+						ExpandingArray<LinkerObject*>	visited;
 
 						if (lo->mFlags & LOBJF_ZEROPAGESET)
 						{
@@ -15275,10 +15428,13 @@ bool NativeCodeBasicBlock::CollectZeroPageSet(ZeroPageSet& locals, ZeroPageSet&
 						}
 						else if (!lo->mProc)
 						{
-							for (int i = 0; i < lo->mNumTemporaries; i++)
+							if (!CollectAssemblerZeroPageSet(lo, global, visited))
 							{
-								for (int j = 0; j < lo->mTempSizes[i]; j++)
-									global += lo->mTemporaries[i] + j;
+								for (int i = 0; i < lo->mNumTemporaries; i++)
+								{
+									for (int j = 0; j < lo->mTempSizes[i]; j++)
+										global += lo->mTemporaries[i] + j;
+								}
 							}
 						}
 						else
@@ -15315,6 +15471,58 @@ bool NativeCodeBasicBlock::CollectZeroPageSet(ZeroPageSet& locals, ZeroPageSet&
 	return true;
 }
 
+void NativeCodeBasicBlock::CollectChangedCPURegs(uint32& regs)
+{
+	if (!mVisited)
+	{
+		mVisited = true;
+
+		for (int i = 0; i < mIns.Size(); i++)
+		{
+			const NativeCodeInstruction& ins(mIns[i]);
+
+			switch (ins.mType)
+			{
+			case ASMIT_JSR:
+			case ASMIT_JMP:
+			case ASMIT_BRK:
+			case ASMIT_RTI:
+			case ASMIT_BYTE:
+			case ASMIT_INV:
+				regs |= LIVE_CPU_REG_A | LIVE_CPU_REG_X | LIVE_CPU_REG_Y;
+				break;
+			case ASMIT_PLA:
+			case ASMIT_ISC:
+				regs |= LIVE_CPU_REG_A;
+				break;
+			case ASMIT_TSX:
+			case ASMIT_PLX:
+			case ASMIT_SBX:
+				regs |= LIVE_CPU_REG_X;
+				break;
+			case ASMIT_LAX:
+				regs |= LIVE_CPU_REG_A | LIVE_CPU_REG_X;
+				break;
+			case ASMIT_PLY:
+				regs |= LIVE_CPU_REG_Y;
+				break;
+			default:
+				if (ins.ChangesAccu() || ins.mMode == ASMIM_IMPLIED && (ins.mType == ASMIT_INC || ins.mType == ASMIT_DEC))
+					regs |= LIVE_CPU_REG_A;
+				if (ins.ChangesXReg())
+					regs |= LIVE_CPU_REG_X;
+				if (ins.ChangesYReg())
+					regs |= LIVE_CPU_REG_Y;
+			}
+		}
+
+		if (mTrueJump)
+			mTrueJump->CollectChangedCPURegs(regs);
+		if (mFalseJump)
+			mFalseJump->CollectChangedCPURegs(regs);
+	}
+}
+
 void NativeCodeBasicBlock::CollectZeroPageUsage(NumberSet& used, NumberSet &modified, NumberSet& pairs)
 {
 	if (!mVisited)
@@ -17499,6 +17707,9 @@ bool NativeCodeBasicBlock::CanGlobalSwapXY(void)
 	{
 		mVisited = true;
 
+		if (mEntryRegX || mEntryRegY || mExitRegX)
+			return false;
+
 		for (int i = 0; i < mIns.Size(); i++)
 		{
 			NativeCodeInstruction& ins(mIns[i]);
@@ -17511,6 +17722,8 @@ bool NativeCodeBasicBlock::CanGlobalSwapXY(void)
 				return false;
 			if (ins.mType == ASMIT_JSR && (ins.mFlags & (NCIF_USE_CPU_REG_X | NCIF_USE_CPU_REG_Y | NCIF_USE_ZP_32_X)))
 				return false;
+			if (ins.mType == ASMIT_JSR && ins.mLinkerObject && (ins.mLinkerObject->mFlags & LOBJF_RET_REG_X))
+				return false;
 		}
 
 		if (mTrueJump && !mTrueJump->CanGlobalSwapXY())
@@ -17831,7 +18044,7 @@ bool NativeCodeBasicBlock::LocalSwapXY(void)
 
 		int pre = -1;
 
-		if (mEntryRequiredRegs[CPU_REG_X] || mEntryRequiredRegs[CPU_REG_Y])
+		if (mEntryRequiredRegs[CPU_REG_X] || mEntryRequiredRegs[CPU_REG_Y] || mEntryRegX || mEntryRegY)
 			pre = -2;
 
 		for (int i = 0; i < mIns.Size(); i++)
@@ -22179,7 +22392,7 @@ bool NativeCodeBasicBlock::ReduceLocalXPressure(void)
 						changed = true;
 						break;
 					}
-					else if (eins.ChangesYReg() || (eins.mMode == ASMIM_ABSOLUTE_X && !HasAsmInstructionMode(eins.mType, ASMIM_ABSOLUTE_Y)))
+					else if (eins.ChangesYReg() || (eins.mMode == ASMIM_ABSOLUTE_X && !HasAsmInstructionMode(eins.mType, ASMIM_ABSOLUTE_Y)) || (eins.mType == ASMIT_RTS && eins.RequiresXReg()))
 					{
 						break;
 					}
@@ -22993,18 +23206,58 @@ bool NativeCodeBasicBlock::LoopRegisterXYMap(void)
 						i++;
 					}
 
-					bool	inner = true;
+					// Blocks of loops nested inside this loop are weighted by their
+					// nesting depth, so the index of an inner loop can stay in a
+					// register across the whole nest
+
+					ExpandingArray<int>	lweights;
+					for (int i = 0; i < lblocks.Size(); i++)
+						lweights.Push(1);
+
+					for (int i = 0; i < lblocks.Size(); i++)
+					{
+						NativeCodeBasicBlock* h = lblocks[i];
+						if (h->mLoopHead && h != this)
+						{
+							ExpandingArray<NativeCodeBasicBlock*>	hblocks;
+							hblocks.Push(h);
+							for (int j = 0; j < h->mEntryBlocks.Size(); j++)
+							{
+								NativeCodeBasicBlock* b = h->mEntryBlocks[j];
+								if (b != h && lblocks.Contains(b) && b->IsDominatedBy(h) && !hblocks.Contains(b))
+									hblocks.Push(b);
+							}
+
+							int k = 1;
+							while (k < hblocks.Size())
+							{
+								NativeCodeBasicBlock* b = hblocks[k];
+								for (int j = 0; j < b->mEntryBlocks.Size(); j++)
+								{
+									NativeCodeBasicBlock* cb = b->mEntryBlocks[j];
+									if (lblocks.Contains(cb) && !hblocks.Contains(cb))
+										hblocks.Push(cb);
+								}
+								k++;
+							}
+
+							if (hblocks.Size() > 1 || h->mTrueJump == h || h->mFalseJump == h)
+							{
+								for (int j = 0; j < hblocks.Size(); j++)
+								{
+									int li = lblocks.IndexOf(hblocks[j]);
+									if (lweights[li] < 16)
+										lweights[li] *= 4;
+								}
+							}
+						}
+					}
 
 					NativeCodeBasicBlock* eblock = nullptr;
 					i = 0;
 					while (i < lblocks.Size())
 					{
 						NativeCodeBasicBlock* b = lblocks[i];
-						if (b->mLoopHead && b != this)
-						{
-							inner = false;
-							break;
-						}
 						if (b->mFalseJump && !(lblocks.Contains(b->mFalseJump) && lblocks.Contains(b->mTrueJump)))
 						{
 							NativeCodeBasicBlock* eblock = lblocks.Contains(b->mFalseJump) ? b->mTrueJump : b->mFalseJump;
@@ -23038,7 +23291,7 @@ bool NativeCodeBasicBlock::LoopRegisterXYMap(void)
 						i++;
 					}
 
-					if (inner && eblocks.Size() > 0)
+					if (eblocks.Size() > 0)
 					{
 						bool	xfree = !mEntryRequiredRegs[CPU_REG_X], yfree = !mEntryRequiredRegs[CPU_REG_Y];
 
@@ -23052,6 +23305,7 @@ bool NativeCodeBasicBlock::LoopRegisterXYMap(void)
 							for (int i = 0; i < lblocks.Size(); i++)
 							{
 								NativeCodeBasicBlock* b(lblocks[i]);
+								int	w = lweights[i];
 
 								for (int j = 0; j < b->mIns.Size(); j++)
 								{
@@ -23069,11 +23323,11 @@ bool NativeCodeBasicBlock::LoopRegisterXYMap(void)
 									else if (ins.mMode == ASMIM_ZERO_PAGE && iregs[ins.mAddress] >= 0)
 									{
 										if (ins.mType == ASMIT_INC || ins.mType == ASMIT_DEC)
-											iregs[ins.mAddress] += 5;
+											iregs[ins.mAddress] += 5 * w;
 										else if (ins.mType == ASMIT_LDA || ins.mType == ASMIT_STA)
-											iregs[ins.mAddress] += 3;
+											iregs[ins.mAddress] += 3 * w;
 										else if (ins.IsCommutative() && j > 0 && b->mIns[j - 1].mType == ASMIT_LDA && (b->mIns[j - 1].mMode == ASMIM_IMMEDIATE || b->mIns[j - 1].mMode == ASMIM_IMMEDIATE_ADDRESS))
-											iregs[ins.mAddress] += 3;
+											iregs[ins.mAddress] += 3 * w;
 										else
 											iregs[ins.mAddress] = -1;
 									}
@@ -28233,7 +28487,7 @@ bool NativeCodeBasicBlock::FindGlobalAddress(int at, int reg, int& apos)
 			apos = j + 0;
 			return true;
 		}
-		if (mIns[j + 3].mMode == ASMIM_ZERO_PAGE && (mIns[j + 3].mAddress == reg || mIns[j + 3].mAddress == reg + 1) && mIns[j + 3].ChangesAddress())
+		if (mIns[j + 3].ChangesZeroPage(reg) || mIns[j + 3].ChangesZeroPage(reg + 1))
 			return false;
 
 		j--;
@@ -30033,15 +30287,12 @@ bool NativeCodeBasicBlock::IsDominatedBy(const NativeCodeBasicBlock* block) cons
 #else
 	else
 	{
+		bool r1 = (mDomNum >= 0 && block->mDomNum >= 0) && block->mDomNum <= mDomNum && mDomNum < block->mDomEnd;
+		bool r2 = false;
 		NativeCodeBasicBlock* dom = mDominator;
-		while (dom)
-		{
-			if (dom == block)
-				return true;
-			dom = dom->mDominator;
-		}
-
-		return false;
+		while (dom) { if (dom == block) { r2 = true; break; } dom = dom->mDominator; }
+		if (r1 != r2) fprintf(stderr, "DOMMISMATCH %d %d : %d %d [%d %d) [%d %d)\n", mIndex, block->mIndex, r1, r2, mDomNum, mDomEnd, block->mDomNum, block->mDomEnd);
+		return r1;
 	}
 #endif
 }
@@ -37460,7 +37711,7 @@ bool NativeCodeBasicBlock::OptimizeLoopRegisterWrapAround(void)
 								NativeCodeInstruction& ins(hblock->mIns[i]);
 								if (!usedX && ins.mType == ASMIT_LDX && ins.mMode == ASMIM_ZERO_PAGE)
 								{
-									if (ins.mAddress == finalA && !mExitRequiredRegs[CPU_REG_X])
+									if (ins.mAddress == finalA && !mExitRequiredRegs[CPU_REG_X] && !(ins.mLive & LIVE_CPU_REG_Z))
 									{
 										int k = sz - 1;
 										if (mIns[k].mType == ASMIT_CMP || mIns[k].mType == ASMIT_CPX || mIns[k].mType == ASMIT_CPY)
@@ -52498,6 +52749,580 @@ void NativeCodeBasicBlock::CheckLive(void)
 #endif
 }
 
+// Register usage for the late 65C02 and 6502X code selection, unlike the
+// NMOS helpers this covers the stack and flag instructions and treats
+// everything else as a barrier
+
+static uint32 LateRequiredRegs(const NativeCodeInstruction& ins)
+{
+	uint32	live = 0;
+
+	switch (ins.mMode)
+	{
+	case ASMIM_RELATIVE:
+		return LIVE_CPU_REG | LIVE_CPU_REG_V;
+	case ASMIM_ZERO_PAGE_X:
+	case ASMIM_ABSOLUTE_X:
+	case ASMIM_INDIRECT_X:
+		live |= LIVE_CPU_REG_X;
+		break;
+	case ASMIM_ZERO_PAGE_Y:
+	case ASMIM_ABSOLUTE_Y:
+	case ASMIM_INDIRECT_Y:
+		live |= LIVE_CPU_REG_Y;
+		break;
+	}
+
+	switch (ins.mType)
+	{
+	case ASMIT_ADC:
+	case ASMIT_SBC:
+	case ASMIT_ISC:
+		return live | LIVE_CPU_REG_A | LIVE_CPU_REG_C;
+	case ASMIT_SAX:
+	case ASMIT_SBX:
+		return live | LIVE_CPU_REG_A | LIVE_CPU_REG_X;
+	case ASMIT_ROL:
+	case ASMIT_ROR:
+		live |= LIVE_CPU_REG_C;
+	case ASMIT_ASL:
+	case ASMIT_LSR:
+	case ASMIT_INC:
+	case ASMIT_DEC:
+		if (ins.mMode == ASMIM_IMPLIED)
+			live |= LIVE_CPU_REG_A;
+		return live;
+	case ASMIT_AND:
+	case ASMIT_ORA:
+	case ASMIT_EOR:
+	case ASMIT_CMP:
+	case ASMIT_BIT:
+	case ASMIT_STA:
+	case ASMIT_PHA:
+	case ASMIT_TAX:
+	case ASMIT_TAY:
+	case ASMIT_TSB:
+	case ASMIT_TRB:
+	case ASMIT_DCP:
+		return live | LIVE_CPU_REG_A;
+	case ASMIT_STX:
+	case ASMIT_CPX:
+	case ASMIT_TXA:
+	case ASMIT_INX:
+	case ASMIT_DEX:
+	case ASMIT_PHX:
+	case ASMIT_TXS:
+		return live | LIVE_CPU_REG_X;
+	case ASMIT_STY:
+	case ASMIT_CPY:
+	case ASMIT_TYA:
+	case ASMIT_INY:
+	case ASMIT_DEY:
+	case ASMIT_PHY:
+		return live | LIVE_CPU_REG_Y;
+	case ASMIT_PHP:
+		return live | LIVE_CPU_REG_C | LIVE_CPU_REG_Z | LIVE_CPU_REG_V;
+	case ASMIT_JSR:
+		if (ins.mFlags & NCIF_USE_CPU_REG_A)
+			live |= LIVE_CPU_REG_A;
+		if (ins.mFlags & NCIF_USE_CPU_REG_X)
+			live |= LIVE_CPU_REG_X;
+		if (ins.mFlags & NCIF_USE_CPU_REG_Y)
+			live |= LIVE_CPU_REG_Y;
+		if (ins.mFlags & NCIF_USE_CPU_REG_C)
+			live |= LIVE_CPU_REG_C;
+		return live;
+	case ASMIT_LDA:
+	case ASMIT_LDX:
+	case ASMIT_LDY:
+	case ASMIT_LAX:
+	case ASMIT_STZ:
+	case ASMIT_PLA:
+	case ASMIT_PLX:
+	case ASMIT_PLY:
+	case ASMIT_PLP:
+	case ASMIT_TSX:
+	case ASMIT_CLC:
+	case ASMIT_SEC:
+	case ASMIT_CLV:
+	case ASMIT_CLI:
+	case ASMIT_SEI:
+	case ASMIT_CLD:
+	case ASMIT_SED:
+	case ASMIT_NOP:
+		return live;
+	default:
+		return LIVE_CPU_REG | LIVE_CPU_REG_V;
+	}
+}
+
+static uint32 LateChangedRegs(const NativeCodeInstruction& ins)
+{
+	if (ins.mMode == ASMIM_RELATIVE)
+		return 0;
+
+	switch (ins.mType)
+	{
+	case ASMIT_ADC:
+	case ASMIT_SBC:
+	case ASMIT_ISC:
+		return LIVE_CPU_REG_A | LIVE_CPU_REG_C | LIVE_CPU_REG_Z | LIVE_CPU_REG_V;
+	case ASMIT_LAX:
+		return LIVE_CPU_REG_A | LIVE_CPU_REG_X | LIVE_CPU_REG_Z;
+	case ASMIT_SBX:
+		return LIVE_CPU_REG_X | LIVE_CPU_REG_C | LIVE_CPU_REG_Z;
+	case ASMIT_ASL:
+	case ASMIT_LSR:
+	case ASMIT_ROL:
+	case ASMIT_ROR:
+		if (ins.mMode == ASMIM_IMPLIED)
+			return LIVE_CPU_REG_A | LIVE_CPU_REG_C | LIVE_CPU_REG_Z;
+		else
+			return LIVE_CPU_REG_C | LIVE_CPU_REG_Z;
+	case ASMIT_INC:
+	case ASMIT_DEC:
+		if (ins.mMode == ASMIM_IMPLIED)
+			return LIVE_CPU_REG_A | LIVE_CPU_REG_Z;
+		else
+			return LIVE_CPU_REG_Z;
+	case ASMIT_AND:
+	case ASMIT_ORA:
+	case ASMIT_EOR:
+	case ASMIT_LDA:
+	case ASMIT_TXA:
+	case ASMIT_TYA:
+	case ASMIT_PLA:
+		return LIVE_CPU_REG_A | LIVE_CPU_REG_Z;
+	case ASMIT_LDX:
+	case ASMIT_TAX:
+	case ASMIT_INX:
+	case ASMIT_DEX:
+	case ASMIT_TSX:
+	case ASMIT_PLX:
+		return LIVE_CPU_REG_X | LIVE_CPU_REG_Z;
+	case ASMIT_LDY:
+	case ASMIT_TAY:
+	case ASMIT_INY:
+	case ASMIT_DEY:
+	case ASMIT_PLY:
+		return LIVE_CPU_REG_Y | LIVE_CPU_REG_Z;
+	case ASMIT_CMP:
+	case ASMIT_CPX:
+	case ASMIT_CPY:
+	case ASMIT_DCP:
+		return LIVE_CPU_REG_C | LIVE_CPU_REG_Z;
+	case ASMIT_BIT:
+		return LIVE_CPU_REG_Z | LIVE_CPU_REG_V;
+	case ASMIT_TSB:
+	case ASMIT_TRB:
+		return LIVE_CPU_REG_Z;
+	case ASMIT_CLC:
+	case ASMIT_SEC:
+		return LIVE_CPU_REG_C;
+	case ASMIT_CLV:
+		return LIVE_CPU_REG_V;
+	case ASMIT_PLP:
+		return LIVE_CPU_REG_C | LIVE_CPU_REG_Z | LIVE_CPU_REG_V;
+	case ASMIT_JSR:
+		return LIVE_CPU_REG | LIVE_CPU_REG_V;
+	default:
+		return 0;
+	}
+}
+
+uint32 NativeCodeBasicBlock::BuildLateLiveRegs(void)
+{
+	uint32	live;
+
+	if (!mTrueJump)
+		live = LIVE_CPU_REG | LIVE_CPU_REG_V;
+	else if (!mFalseJump)
+	{
+		live = mTrueJump->mTemp;
+
+		// The jump may be turned into a branch on a known flag
+		if (mNDataSet.mRegs[CPU_REG_C].mMode == NRDM_IMMEDIATE)
+			live |= LIVE_CPU_REG_C;
+		if (mNDataSet.mRegs[CPU_REG_Z].mMode == NRDM_IMMEDIATE)
+			live |= LIVE_CPU_REG_Z;
+	}
+	else
+	{
+		live = mTrueJump->mTemp | mFalseJump->mTemp;
+
+		switch (mBranch)
+		{
+		case ASMIT_BEQ:
+		case ASMIT_BNE:
+		case ASMIT_BMI:
+		case ASMIT_BPL:
+			live |= LIVE_CPU_REG_Z;
+			break;
+		case ASMIT_BCC:
+		case ASMIT_BCS:
+			live |= LIVE_CPU_REG_C;
+			break;
+		default:
+			live |= LIVE_CPU_REG | LIVE_CPU_REG_V;
+		}
+	}
+
+	for (int i = mIns.Size() - 1; i >= 0; i--)
+	{
+		mIns[i].mLive = live;
+		live = (live & ~LateChangedRegs(mIns[i])) | LateRequiredRegs(mIns[i]);
+	}
+
+	return live;
+}
+
+bool NativeCodeBasicBlock::Optimize65C02(void)
+{
+	// Rewrite NMOS sequences into their shorter CMOS forms, runs after the
+	// frame code is in place, so blocks with local branches keep their size
+
+	for (int i = 0; i < mIns.Size(); i++)
+		if (mIns[i].mMode == ASMIM_RELATIVE)
+			return false;
+
+	bool	changed = false;
+
+	BuildLateLiveRegs();
+
+	int i = 0;
+	while (i < mIns.Size())
+	{
+		NativeCodeInstruction& ins(mIns[i]);
+		bool	progress = false;
+
+		if (i + 1 < mIns.Size())
+		{
+			NativeCodeInstruction& nins(mIns[i + 1]);
+
+			if ((ins.mType == ASMIT_TXA || ins.mType == ASMIT_TYA) && nins.mType == ASMIT_PHA && !(nins.mLive & (LIVE_CPU_REG_A | LIVE_CPU_REG_Z)))
+			{
+				ins.mType = ins.mType == ASMIT_TXA ? ASMIT_PHX : ASMIT_PHY;
+				mIns.Remove(i + 1);
+				progress = true;
+			}
+			else if (ins.mType == ASMIT_PLA && (nins.mType == ASMIT_TAX || nins.mType == ASMIT_TAY) && !(nins.mLive & LIVE_CPU_REG_A))
+			{
+				ins.mType = nins.mType == ASMIT_TAX ? ASMIT_PLX : ASMIT_PLY;
+				mIns.Remove(i + 1);
+				progress = true;
+			}
+			else if (
+				(ins.mType == ASMIT_CLC && nins.mType == ASMIT_ADC || ins.mType == ASMIT_SEC && nins.mType == ASMIT_SBC) &&
+				nins.mMode == ASMIM_IMMEDIATE && (nins.mAddress == 1 || nins.mAddress == 0xff) && !(nins.mLive & (LIVE_CPU_REG_C | LIVE_CPU_REG_V)))
+			{
+				if ((nins.mType == ASMIT_ADC) == (nins.mAddress == 1))
+					ins.mType = ASMIT_INC;
+				else
+					ins.mType = ASMIT_DEC;
+				ins.mMode = ASMIM_IMPLIED;
+				mIns.Remove(i + 1);
+				progress = true;
+			}
+			else if (
+				i + 2 < mIns.Size() && ins.mType == ASMIT_LDA && (ins.mMode == ASMIM_ZERO_PAGE || ins.mMode == ASMIM_ABSOLUTE) && !(ins.mFlags & NCIF_VOLATILE) &&
+				(nins.mType == ASMIT_ORA || nins.mType == ASMIT_AND) && nins.mMode == ASMIM_IMMEDIATE &&
+				mIns[i + 2].mType == ASMIT_STA && mIns[i + 2].SameEffectiveAddress(ins) && mIns[i + 2].mLinkerObject == ins.mLinkerObject && !(mIns[i + 2].mFlags & NCIF_VOLATILE) && !(mIns[i + 2].mLive & (LIVE_CPU_REG_A | LIVE_CPU_REG_Z)))
+			{
+				if (nins.mType == ASMIT_ORA)
+					ins = NativeCodeInstruction(ins.mIns, ASMIT_LDA, ASMIM_IMMEDIATE, nins.mAddress & 0xff);
+				else
+					ins = NativeCodeInstruction(ins.mIns, ASMIT_LDA, ASMIM_IMMEDIATE, ~nins.mAddress & 0xff);
+				nins = NativeCodeInstruction(nins.mIns, nins.mType == ASMIT_ORA ? ASMIT_TSB : ASMIT_TRB, mIns[i + 2]);
+				mIns.Remove(i + 2);
+				progress = true;
+			}
+		}
+
+		if (!progress && (ins.mType == ASMIT_LDA || ins.mType == ASMIT_LDX || ins.mType == ASMIT_LDY) && ins.mMode == ASMIM_IMMEDIATE && ins.mAddress == 0 && !(ins.mLive & LIVE_CPU_REG_Z))
+		{
+			// Zero in a register that is only stored or used as zero index, replace
+			// the stores with STZ and the indexed accesses with (zp)
+
+			uint32		reg;
+			AsmInsType	store;
+
+			if (ins.mType == ASMIT_LDA)
+			{
+				reg = LIVE_CPU_REG_A;
+				store = ASMIT_STA;
+			}
+			else if (ins.mType == ASMIT_LDX)
+			{
+				reg = LIVE_CPU_REG_X;
+				store = ASMIT_STX;
+			}
+			else
+			{
+				reg = LIVE_CPU_REG_Y;
+				store = ASMIT_STY;
+			}
+
+			bool	used = false, fail = false;
+			int j = i + 1;
+			while (!fail && j < mIns.Size())
+			{
+				const NativeCodeInstruction& jins(mIns[j]);
+
+				if (jins.mType == store && HasAsmInstructionMode(ASMIT_STZ, jins.mMode))
+					used = true;
+				else if (reg == LIVE_CPU_REG_Y && jins.mMode == ASMIM_INDIRECT_Y && HasAsmInstructionMode(jins.mType, ASMIM_ZERO_PAGE_INDIRECT))
+					used = true;
+				else if (LateRequiredRegs(jins) & reg)
+					fail = true;
+				else if (LateChangedRegs(jins) & reg)
+					break;
+				j++;
+			}
+
+			if (j == mIns.Size() && (mIns.Last().mLive & reg))
+				fail = true;
+
+			if (used && !fail)
+			{
+				for (int k = i + 1; k < j; k++)
+				{
+					if (mIns[k].mType == store)
+						mIns[k].mType = ASMIT_STZ;
+					else if (reg == LIVE_CPU_REG_Y && mIns[k].mMode == ASMIM_INDIRECT_Y)
+						mIns[k].mMode = ASMIM_ZERO_PAGE_INDIRECT;
+				}
+				mIns.Remove(i);
+				progress = true;
+			}
+		}
+
+		if (progress)
+		{
+			changed = true;
+			BuildLateLiveRegs();
+		}
+		else
+			i++;
+	}
+
+	return changed;
+}
+
+bool NativeCodeBasicBlock::Optimize6502X(void)
+{
+	// Fold common NMOS sequences into the stable undocumented opcodes, same
+	// constraints as the 65C02 selection
+
+	for (int i = 0; i < mIns.Size(); i++)
+		if (mIns[i].mMode == ASMIM_RELATIVE)
+			return false;
+
+	bool	changed = false;
+
+	BuildLateLiveRegs();
+
+	int i = 0;
+	while (i < mIns.Size())
+	{
+		NativeCodeInstruction& ins(mIns[i]);
+		bool	progress = false;
+
+		if (i + 1 < mIns.Size())
+		{
+			NativeCodeInstruction& nins(mIns[i + 1]);
+
+			if ((ins.mType == ASMIT_LDA && nins.mType == ASMIT_TAX || ins.mType == ASMIT_LDX && nins.mType == ASMIT_TXA) && HasAsmInstructionMode(ASMIT_LAX, ins.mMode))
+			{
+				ins.mType = ASMIT_LAX;
+				ins.mLive = nins.mLive;
+				mIns.Remove(i + 1);
+				progress = true;
+			}
+			else if (
+				(ins.mType == ASMIT_LDA && nins.mType == ASMIT_LDX || ins.mType == ASMIT_LDX && nins.mType == ASMIT_LDA) && HasAsmInstructionMode(ASMIT_LAX, ins.mMode) &&
+				nins.SameEffectiveAddress(ins) && nins.mLinkerObject == ins.mLinkerObject && !(ins.mFlags & NCIF_VOLATILE))
+			{
+				ins.mType = ASMIT_LAX;
+				ins.mLive = nins.mLive;
+				mIns.Remove(i + 1);
+				progress = true;
+			}
+			else if (
+				(ins.mType == ASMIT_DEC && nins.mType == ASMIT_CMP || ins.mType == ASMIT_INC && nins.mType == ASMIT_SBC) && HasAsmInstructionMode(ASMIT_DCP, ins.mMode) &&
+				nins.SameEffectiveAddress(ins) && nins.mLinkerObject == ins.mLinkerObject && !(ins.mFlags & NCIF_VOLATILE))
+			{
+				ins.mType = ins.mType == ASMIT_DEC ? ASMIT_DCP : ASMIT_ISC;
+				ins.mLive = nins.mLive;
+				mIns.Remove(i + 1);
+				progress = true;
+			}
+			else if (
+				i + 2 < mIns.Size() && ins.mType == ASMIT_TXA && nins.mType == ASMIT_AND && nins.mMode == ASMIM_IMMEDIATE &&
+				mIns[i + 2].mType == ASMIT_STA && HasAsmInstructionMode(ASMIT_SAX, mIns[i + 2].mMode) && !(mIns[i + 2].mLive & (LIVE_CPU_REG_A | LIVE_CPU_REG_Z)))
+			{
+				ins = NativeCodeInstruction(ins.mIns, ASMIT_LDA, ASMIM_IMMEDIATE, nins.mAddress & 0xff);
+				mIns[i + 2].mType = ASMIT_SAX;
+				mIns.Remove(i + 1);
+				progress = true;
+			}
+			else if (
+				i + 3 < mIns.Size() && ins.mType == ASMIT_TXA &&
+				(nins.mType == ASMIT_CLC && mIns[i + 2].mType == ASMIT_ADC || nins.mType == ASMIT_SEC && mIns[i + 2].mType == ASMIT_SBC) && mIns[i + 2].mMode == ASMIM_IMMEDIATE &&
+				mIns[i + 3].mType == ASMIT_TAX && !(mIns[i + 3].mLive & (LIVE_CPU_REG_A | LIVE_CPU_REG_C | LIVE_CPU_REG_V)))
+			{
+				int	k = mIns[i + 2].mType == ASMIT_ADC ? -mIns[i + 2].mAddress : mIns[i + 2].mAddress;
+
+				ins = NativeCodeInstruction(ins.mIns, ASMIT_LDA, ASMIM_IMMEDIATE, 0xff);
+				mIns[i + 3] = NativeCodeInstruction(mIns[i + 3].mIns, ASMIT_SBX, ASMIM_IMMEDIATE, k & 0xff);
+				mIns.Remove(i + 1, 2);
+				progress = true;
+			}
+		}
+
+		if (!progress && (ins.mType == ASMIT_INX || ins.mType == ASMIT_DEX))
+		{
+			// Long runs of index increments are cheaper as one subtraction
+
+			int j = i + 1;
+			while (j < mIns.Size() && mIns[j].mType == ins.mType)
+				j++;
+
+			if (j - i >= 4 && !(mIns[j - 1].mLive & (LIVE_CPU_REG_A | LIVE_CPU_REG_C)))
+			{
+				int	k = ins.mType == ASMIT_INX ? i - j : j - i;
+
+				mIns[j - 1] = NativeCodeInstruction(mIns[j - 1].mIns, ASMIT_SBX, ASMIM_IMMEDIATE, k & 0xff);
+				ins = NativeCodeInstruction(ins.mIns, ASMIT_LDA, ASMIM_IMMEDIATE, 0xff);
+				mIns.Remove(i + 1, j - i - 2);
+				progress = true;
+			}
+		}
+
+		if (progress)
+		{
+			changed = true;
+			BuildLateLiveRegs();
+		}
+		else
+			i++;
+	}
+
+	return changed;
+}
+
+bool NativeCodeBasicBlock::PatchPointerLoop(NativeCodeBasicBlock* pblock)
+{
+	// Replace (zp),y accesses through loop invariant pointers with abs,y
+	// accesses, whose operand is patched with the pointer before the loop
+
+	for (int i = 0; i < mIns.Size(); i++)
+	{
+		if (mIns[i].mType == ASMIT_JSR || mIns[i].mMode == ASMIM_RELATIVE)
+			return false;
+	}
+
+	// Patching costs about eight cycles per access, not worth it for short
+	// loops with a visible trip count
+
+	if (mIns.Size() > 0 && (mIns.Last().mType == ASMIT_CPX || mIns.Last().mType == ASMIT_CPY) && mIns.Last().mMode == ASMIM_IMMEDIATE && mIns.Last().mAddress < 16)
+		return false;
+
+	ExpandingArray<int>	ptrs;
+
+	for (int i = 0; i < mIns.Size(); i++)
+	{
+		const NativeCodeInstruction& ins(mIns[i]);
+		if (ins.mMode == ASMIM_INDIRECT_Y && !ins.mLinkerObject && HasAsmInstructionMode(ins.mType, ASMIM_ABSOLUTE_Y) && !ptrs.Contains(ins.mAddress) &&
+			!ChangesZeroPage(ins.mAddress) && !ChangesZeroPage(ins.mAddress + 1))
+			ptrs.Push(ins.mAddress);
+	}
+
+	if (ptrs.Size() == 0)
+		return false;
+
+	NativeCodeBasicBlock* sblock;
+	int	at;
+
+	if (pblock->mFalseJump)
+	{
+		if (mTemp & (LIVE_CPU_REG_A | LIVE_CPU_REG_Z))
+			return false;
+
+		sblock = mProc->AllocateBlock();
+		sblock->mTrueJump = this;
+		sblock->mBranch = ASMIT_JMP;
+		sblock->mNumEntries = 1;
+		sblock->mEntryBlocks.Push(pblock);
+		sblock->mFrameOffset = mFrameOffset;
+
+		if (pblock->mTrueJump == this)
+			pblock->mTrueJump = sblock;
+		if (pblock->mFalseJump == this)
+			pblock->mFalseJump = sblock;
+
+		for (int i = 0; i < mEntryBlocks.Size(); i++)
+			if (mEntryBlocks[i] == pblock)
+				mEntryBlocks[i] = sblock;
+
+		at = 0;
+	}
+	else
+	{
+		// Find the latest point in the predecessor where the accu is free
+		// and all pointers have their final value
+
+		sblock = pblock;
+		at = pblock->mIns.Size();
+		while (at >= 0)
+		{
+			uint32	live = at > 0 ? pblock->mIns[at - 1].mLive : pblock->mTemp;
+			if (!(live & (LIVE_CPU_REG_A | LIVE_CPU_REG_Z)))
+				break;
+			if (at == 0)
+				return false;
+
+			const NativeCodeInstruction& ins(pblock->mIns[at - 1]);
+			for (int i = 0; i < ptrs.Size(); i++)
+			{
+				if (ins.ChangesZeroPage(ptrs[i]) || ins.ChangesZeroPage(ptrs[i] + 1))
+					return false;
+			}
+
+			at--;
+		}
+	}
+
+	for (int i = 0; i < ptrs.Size(); i++)
+	{
+		int	ids = mProc->mPatchBlocks.Size();
+
+		for (int j = 0; j < mIns.Size(); j++)
+		{
+			NativeCodeInstruction& ins(mIns[j]);
+			if (ins.mMode == ASMIM_INDIRECT_Y && !ins.mLinkerObject && ins.mAddress == ptrs[i])
+			{
+				ins.mMode = ASMIM_ABSOLUTE_Y;
+				ins.mAddress = 0;
+				ins.mFlags = (ins.mFlags & NCIF_VOLATILE) | NCIF_SELF_MODIFIED;
+				ins.mParam = mProc->mPatchBlocks.Size();
+				mProc->mPatchBlocks.Push(this);
+				mProc->mPatchOffsets.Push(0);
+			}
+		}
+
+		int	ide = mProc->mPatchBlocks.Size();
+
+		for (int k = 0; k < 2; k++)
+		{
+			sblock->mIns.Insert(at++, NativeCodeInstruction(nullptr, ASMIT_LDA, ASMIM_ZERO_PAGE, ptrs[i] + k));
+			for (int id = ids; id < ide; id++)
+				sblock->mIns.Insert(at++, NativeCodeInstruction(nullptr, ASMIT_STA, ASMIM_ABSOLUTE, k, nullptr, NCIF_SELF_PATCH, id));
+		}
+	}
+
+	return true;
+}
+
 void NativeCodeBasicBlock::Assemble(void)
 {
 	if (!mAssembled)
@@ -53015,6 +53840,8 @@ NativeCodeBasicBlock::NativeCodeBasicBlock(NativeCodeProcedure* proc)
 	mAssembled = false;
 	mLocked = false;
 	mDominator = nullptr;
+	mDomNum = mDomEnd = -1;
+	mLoopDepth = 0;
 	mLoopHeadBlock = nullptr;
 	mLoopTailBlock = nullptr;
 	mSuffixString = nullptr;
@@ -53376,16 +54203,48 @@ void NativeCodeProcedure::Compile(InterCodeProcedure* proc)
 	mEntryBlock->mTrueJump = CompileBlock(mInterProc, mInterProc->mBlocks[0]);
 	mEntryBlock->mBranch = ASMIT_JMP;
 
-	if (proc->mLeafProcedure && proc->mFastCallProcedure && !proc->mInterrupt && !proc->mDispatchedCall && mNoFrame && mStackExpand == 0 && commonFrameSize == 0 && proc->mTempSize <= BC_REG_TMP_SAVED - BC_REG_TMP && (mGenerator->mCompilerOptions & COPT_NATIVE))
+	// Without a prologue the arguments can be passed in the CPU registers, a
+	// callee that is not a leaf uses parameter registers above its own callees,
+	// and no register is live across a call.  Assembler callers use the
+	// parameter registers and the accu
+
+	if (proc->mFastCallProcedure && !proc->mInterrupt && !proc->mDispatchedCall && !proc->mAssemblerCalled && mNoFrame && mStackExpand == 0 && commonFrameSize == 0 && proc->mTempSize <= BC_REG_TMP_SAVED - BC_REG_TMP && (mGenerator->mCompilerOptions & COPT_NATIVE))
 	{
 #if 1
-		if (proc->mParamVars.Size() == 1 && proc->mParamVars[0]->mSize == 1)
+		// Up to three bytes of parameters in A, X and Y, a word in A and X
+
+		LinkerObject* lo = proc->mLinkerObject;
+		int	preg = BC_REG_FPARAMS + proc->mFastCallBase;
+
+		if (lo->mNumTemporaries == 1 && lo->mTemporaries[0] == preg && lo->mTempSizes[0] > 0 && lo->mTempSizes[0] <= 3 && preg + lo->mTempSizes[0] <= BC_REG_FPARAMS_END)
 		{
-			proc->mLinkerObject->mFlags |= LOBJF_ARG_REG_A;
-			proc->mLinkerObject->mTemporaries[0]++;
-			proc->mLinkerObject->mTempSizes[0]--;
-			mEntryBlock->mIns.Insert(0, NativeCodeInstruction(nullptr, ASMIT_STA, ASMIM_ZERO_PAGE, BC_REG_FPARAMS));
-			mEntryBlock->mEntryRegA = true;
+			int		nregs = lo->mTempSizes[0];
+
+			int i = 0;
+			while (i < proc->mParamVars.Size() && (!proc->mParamVars[i] || i >= proc->mFastCallBase && i < proc->mFastCallBase + nregs))
+				i++;
+
+			if (i == proc->mParamVars.Size())
+			{
+				lo->mFlags |= LOBJF_ARG_REG_A;
+				mEntryBlock->mIns.Insert(0, NativeCodeInstruction(nullptr, ASMIT_STA, ASMIM_ZERO_PAGE, preg + 0));
+				mEntryBlock->mEntryRegA = true;
+				if (nregs > 1)
+				{
+					lo->mFlags |= LOBJF_ARG_REG_X;
+					mEntryBlock->mIns.Insert(1, NativeCodeInstruction(nullptr, ASMIT_STX, ASMIM_ZERO_PAGE, preg + 1));
+					mEntryBlock->mEntryRegX = true;
+				}
+				if (nregs > 2)
+				{
+					lo->mFlags |= LOBJF_ARG_REG_Y;
+					mEntryBlock->mIns.Insert(2, NativeCodeInstruction(nullptr, ASMIT_STY, ASMIM_ZERO_PAGE, preg + 2));
+					mEntryBlock->mEntryRegY = true;
+				}
+
+				lo->mTemporaries[0] += nregs;
+				lo->mTempSizes[0] -= nregs;
+			}
 		}
 #endif
 #if 1
@@ -53396,6 +54255,15 @@ void NativeCodeProcedure::Compile(InterCodeProcedure* proc)
 			mExitBlock->mExitRegA = true;
 			proc->mLinkerObject->mFlags |= LOBJF_RET_REG_A;
 		}
+		else if (mExitBlock->mIns[0].mFlags == (NCIF_LOWER | NCIF_UPPER))
+		{
+			mExitBlock->mIns[0].mFlags = NCIF_USE_CPU_REG_A | NCIF_USE_CPU_REG_X;
+			mExitBlock->mIns.Insert(0, NativeCodeInstruction(nullptr, ASMIT_LDX, ASMIM_ZERO_PAGE, BC_REG_ACCU + 1));
+			mExitBlock->mIns.Insert(0, NativeCodeInstruction(nullptr, ASMIT_LDA, ASMIM_ZERO_PAGE, BC_REG_ACCU + 0));
+			mExitBlock->mExitRegA = true;
+			mExitBlock->mExitRegX = true;
+			proc->mLinkerObject->mFlags |= LOBJF_RET_REG_A | LOBJF_RET_REG_X;
+		}
 #endif
 	}
 
@@ -53436,15 +54304,6 @@ void NativeCodeProcedure::Compile(InterCodeProcedure* proc)
 		else
 			mGenerator->mErrors->Error(mLocation, ERRR_INTERRUPT_TO_COMPLEX, "No recursive functions in interrupt");
 
-		if (proc->mHardwareInterrupt)
-		{
-			mEntryBlock->mIns.Push(NativeCodeInstruction(nullptr, ASMIT_PHA));
-			mEntryBlock->mIns.Push(NativeCodeInstruction(nullptr, ASMIT_TXA));
-			mEntryBlock->mIns.Push(NativeCodeInstruction(nullptr, ASMIT_PHA));
-			mEntryBlock->mIns.Push(NativeCodeInstruction(nullptr, ASMIT_TYA));
-			mEntryBlock->mIns.Push(NativeCodeInstruction(nullptr, ASMIT_PHA));
-		}
-
 		bool	usesStack = false;
 
 		if (zpLocal[BC_REG_STACK])
@@ -53454,6 +54313,46 @@ void NativeCodeProcedure::Compile(InterCodeProcedure* proc)
 			zpLocal -= BC_REG_STACK + 1;
 		}
 
+		int	zpSaved = 0;
+		for (int i = 2; i < 256; i++)
+		{
+			if (zpLocal[i])
+				zpSaved++;
+		}
+
+		// A hardware interrupt saves only the CPU registers changed by its
+		// body and callees, the accu is also needed to save the others
+
+		uint32	cpuSaved = 0;
+		if (proc->mHardwareInterrupt)
+		{
+			ResetVisited();
+			mEntryBlock->CollectChangedCPURegs(cpuSaved);
+			if (zpSaved > 0 || (cpuSaved & (LIVE_CPU_REG_X | LIVE_CPU_REG_Y)))
+				cpuSaved |= LIVE_CPU_REG_A;
+
+			if (cpuSaved & LIVE_CPU_REG_A)
+				mEntryBlock->mIns.Push(NativeCodeInstruction(nullptr, ASMIT_PHA));
+			if (cpuSaved & LIVE_CPU_REG_X)
+			{
+				mEntryBlock->mIns.Push(NativeCodeInstruction(nullptr, ASMIT_TXA));
+				mEntryBlock->mIns.Push(NativeCodeInstruction(nullptr, ASMIT_PHA));
+			}
+			if (cpuSaved & LIVE_CPU_REG_Y)
+			{
+				mEntryBlock->mIns.Push(NativeCodeInstruction(nullptr, ASMIT_TYA));
+				mEntryBlock->mIns.Push(NativeCodeInstruction(nullptr, ASMIT_PHA));
+			}
+		}
+
+		if (mGenerator->mCompilerOptions & COPT_VERBOSE2)
+		{
+			printf("Interrupt %s saves %d zero page bytes", mIdent->mString, zpSaved);
+			if (proc->mHardwareInterrupt)
+				printf(" and registers %s%s%s", (cpuSaved & LIVE_CPU_REG_A) ? "A" : "-", (cpuSaved & LIVE_CPU_REG_X) ? "X" : "-", (cpuSaved & LIVE_CPU_REG_Y) ? "Y" : "-");
+			printf("\n");
+		}
+
 		if (usesStack)
 		{
 			mEntryBlock->mIns.Push(NativeCodeInstruction(nullptr, ASMIT_DEC, ASMIM_ZERO_PAGE, BC_REG_STACK + 1));
@@ -53481,14 +54380,18 @@ void NativeCodeProcedure::Compile(InterCodeProcedure* proc)
 			mExitBlock->mIns.Push(NativeCodeInstruction(mExitBlock->mBranchIns, ASMIT_INC, ASMIM_ZERO_PAGE, BC_REG_STACK + 1));
 		}
 
-		if (proc->mHardwareInterrupt)
+		if (cpuSaved & LIVE_CPU_REG_Y)
 		{
 			mExitBlock->mIns.Push(NativeCodeInstruction(mExitBlock->mBranchIns, ASMIT_PLA));
 			mExitBlock->mIns.Push(NativeCodeInstruction(mExitBlock->mBranchIns, ASMIT_TAY));
+		}
+		if (cpuSaved & LIVE_CPU_REG_X)
+		{
 			mExitBlock->mIns.Push(NativeCodeInstruction(mExitBlock->mBranchIns, ASMIT_PLA));
 			mExitBlock->mIns.Push(NativeCodeInstruction(mExitBlock->mBranchIns, ASMIT_TAX));
-			mExitBlock->mIns.Push(NativeCodeInstruction(mExitBlock->mBranchIns, ASMIT_PLA));
 		}
+		if (cpuSaved & LIVE_CPU_REG_A)
+			mExitBlock->mIns.Push(NativeCodeInstruction(mExitBlock->mBranchIns, ASMIT_PLA));
 	
 		// We safe all registers
 		proc->mLinkerObject->mFlags |= LOBJF_ZEROPAGESET;
@@ -53746,7 +54649,7 @@ void NativeCodeProcedure::Compile(InterCodeProcedure* proc)
 		mExitBlock->mIns.Push(NativeCodeInstruction(mExitBlock->mBranchIns, ASMIT_RTS, ASMIM_IMPLIED));
 
 
-	if (mExitBlock->mIns.Size() == 1 && rflags == NCIF_LOWER && !mExitBlock->mExitRegA && (mGenerator->mCompilerOptions & COPT_NATIVE))
+	if (mExitBlock->mIns.Size() == 1 && rflags == NCIF_LOWER && !mExitBlock->mExitRegA && !proc->mAssemblerCalled && (mGenerator->mCompilerOptions & COPT_NATIVE))
 	{
 		if (mExitBlock->mEntryBlocks.Size() == 1)
 		{
@@ -53847,6 +54750,79 @@ void NativeCodeProcedure::Compile(InterCodeProcedure* proc)
 	}
 }
 
+void NativeCodeProcedure::BuildLateLiveRegs(ExpandingArray<NativeCodeBasicBlock*>& blocks)
+{
+	ResetVisited();
+	ResetPatched();
+	mEntryBlock->CollectReachable(blocks);
+
+	for (int i = 0; i < blocks.Size(); i++)
+		blocks[i]->mTemp = 0;
+
+	// Backward register liveness over all blocks, kept in mTemp
+
+	bool	changed;
+	do {
+		changed = false;
+		for (int i = blocks.Size() - 1; i >= 0; i--)
+		{
+			int	live = int(blocks[i]->BuildLateLiveRegs());
+			if (live != blocks[i]->mTemp)
+			{
+				blocks[i]->mTemp = live;
+				changed = true;
+			}
+		}
+	} while (changed);
+}
+
+void NativeCodeProcedure::OptimizeCPUExtensions(void)
+{
+	ExpandingArray<NativeCodeBasicBlock*>	blocks;
+
+	BuildLateLiveRegs(blocks);
+
+	for (int i = 0; i < blocks.Size(); i++)
+	{
+		if (mGenerator->mCompilerOptions & COPT_CPU_65C02)
+			blocks[i]->Optimize65C02();
+		else if (mGenerator->mCompilerOptions & COPT_CPU_6502X)
+			blocks[i]->Optimize6502X();
+	}
+}
+
+void NativeCodeProcedure::OptimizeSelfModifyingLoops(void)
+{
+	ExpandingArray<NativeCodeBasicBlock*>	blocks;
+
+	BuildLateLiveRegs(blocks);
+
+	for (int i = 0; i < blocks.Size(); i++)
+	{
+		NativeCodeBasicBlock* block = blocks[i];
+
+		if (block != mEntryBlock && (block->mTrueJump == block || block->mFalseJump == block))
+		{
+			// Single block loop with a single entry from outside
+
+			NativeCodeBasicBlock* pblock = nullptr;
+			int		npred = 0;
+
+			for (int j = 0; j < blocks.Size(); j++)
+			{
+				if (blocks[j] != block && (blocks[j]->mTrueJump == block || blocks[j]->mFalseJump == block))
+				{
+					pblock = blocks[j];
+					npred++;
+				}
+			}
+
+			if (npred == 1)
+				block->PatchPointerLoop(pblock);
+		}
+	}
+}
+
 void NativeCodeProcedure::Assemble(void)
 {
 	CheckFunc = !strcmp(mIdent->mString, "fighter_ai");
@@ -53857,6 +54833,12 @@ void NativeCodeProcedure::Assemble(void)
 		mEntryBlock->MergeFunctionCalls();
 	}
 
+	if (mGenerator->mCompilerOptions & (COPT_CPU_65C02 | COPT_CPU_6502X))
+		OptimizeCPUExtensions();
+
+	if ((mCompilerOptions & COPT_OPTIMIZE_SELF_MODIFY) && !(mCompilerOptions & COPT_OPTIMIZE_CODE_SIZE) && !(mGenerator->mCompilerOptions & (COPT_TARGET_CRT | COPT_TARGET_NES)))
+		OptimizeSelfModifyingLoops();
+
 	mEntryBlock->Assemble();
 
 	ResetVisited();
@@ -53919,11 +54901,69 @@ void NativeCodeProcedure::Assemble(void)
 		placement[i]->CopyCode(this, data);
 	}
 
+	// Record the short backward branches of inner loops, so the linker
+	// can place them without a page crossing on the taken branch
+
+	for (int i = 0; i < placement.Size(); i++)
+	{
+		NativeCodeBasicBlock* block = placement[i];
+		if (block->mFalseJump)
+		{
+			// Same branch order as in CalculateOffset
+			NativeCodeBasicBlock* target;
+			int	tp = block->mTrueJump->mPlace, fp = block->mFalseJump->mPlace, bp = block->mPlace;
+			if (fp == bp + 1)
+				target = block->mTrueJump;
+			else if (tp == bp + 1)
+				target = block->mFalseJump;
+			else if (fp < bp && tp < bp && bp - tp < 126 && block->mFalseJump->mIns.Size() == 1 && block->mFalseJump->mIns[0].mType == ASMIT_RTS)
+				target = block->mTrueJump;
+			else if (fp > tp && fp < bp || fp < tp && fp > bp)
+				target = block->mFalseJump;
+			else
+				target = block->mTrueJump;
+
+			int	from = block->mOffset + block->mCode.Size();
+			if (target->mOffset <= block->mOffset && target->mOffset - from >= -126)
+			{
+				LinkerObjectLoop	loop;
+				char buffer[100];
+				sprintf_s(buffer, "l%d", target->mIndex);
+				loop.mIdent = Ident::Unique(buffer);
+				loop.mOffset = target->mOffset;
+				loop.mSize = from + 2 - target->mOffset;
+				loop.mAligned = false;
+
+				int j = 0;
+				while (j < mLinkerObject->mLoops.Size() && !(mLinkerObject->mLoops[j].mOffset >= loop.mOffset && mLinkerObject->mLoops[j].mOffset + mLinkerObject->mLoops[j].mSize <= loop.mOffset + loop.mSize))
+					j++;
+				if (j == mLinkerObject->mLoops.Size())
+				{
+					// Drop outer loops that contain this one
+					j = 0;
+					while (j < mLinkerObject->mLoops.Size())
+					{
+						if (loop.mOffset >= mLinkerObject->mLoops[j].mOffset && loop.mOffset + loop.mSize <= mLinkerObject->mLoops[j].mOffset + mLinkerObject->mLoops[j].mSize)
+							mLinkerObject->mLoops.Remove(j);
+						else
+							j++;
+					}
+					mLinkerObject->mLoops.Push(loop);
+				}
+			}
+		}
+	}
+
 
 	for (int i = 0; i < mRelocations.Size(); i++)
 	{
 		LinkerReference& rl(mRelocations[i]);
 		rl.mObject = mLinkerObject;
+		if (rl.mFlags & LREF_SELF_MODIFY)
+		{
+			int	id = rl.mRefOffset >> 1;
+			rl.mRefOffset = mPatchBlocks[id]->mOffset + mPatchOffsets[id] + (rl.mRefOffset & 1);
+		}
 		if (!rl.mRefObject)
 			rl.mRefObject = mLinkerObject;
 		mLinkerObject->AddReference(rl);
@@ -54045,6 +55085,8 @@ void NativeCodeProcedure::RebuildEntry(void)
 		mBlocks[i]->mLoopHead = false;
 		mBlocks[i]->mFromJump = nullptr;
 		mBlocks[i]->mDominator = nullptr;
+		mBlocks[i]->mDomNum = -1;
+		mBlocks[i]->mLoopDepth = 0;
 		mBlocks[i]->mSameBlock = nullptr;
 	}
 
@@ -54055,9 +55097,13 @@ void NativeCodeProcedure::RebuildEntry(void)
 	ResetVisited();
 	mEntryBlock->CollectEntryBlocks(nullptr);
 
-	NativeCodeBasicBlock::DominatorStacks	 stacks;
+	DominatorTree<NativeCodeBasicBlock>	tree;
+
+	ResetVisited();
+	tree.Build(mEntryBlock);
 
-	mEntryBlock->BuildDominatorTree(nullptr, stacks);
+	for (int i = 0; i < tree.Size(); i++)
+		tree.mOrder[i]->mLoopDepth = tree.mLoopDepth[i];
 }
 
 void NativeCodeProcedure::CheckBlocks(bool sequence)
@@ -54596,9 +55642,9 @@ void NativeCodeProcedure::Optimize(void)
 				}
 			}
 
-			if (xmapped)
+			if (xmapped || mEntryBlock->mEntryRegX)
 				xregs[0] = -1;
-			if (ymapped)
+			if (ymapped || mEntryBlock->mEntryRegY)
 				yregs[0] = -1;
 
 			ResetVisited();
@@ -56205,6 +57251,14 @@ NativeCodeGenerator::Runtime& NativeCodeGenerator::ResolveRuntime(const Ident* i
 	return mRuntime[i];
 }
 
+bool NativeCodeGenerator::HasRuntime(const Ident* ident) const
+{
+	for (int i = 0; i < mRuntime.Size(); i++)
+		if (mRuntime[i].mIdent == ident)
+			return mRuntime[i].mLinkerObject != nullptr;
+	return false;
+}
+
 static inline bool isfparam(const NativeCodeInstruction & cins, const NativeCodeInstruction & ins)
 {
 	if (cins.mFlags & NCIF_RUNTIME)
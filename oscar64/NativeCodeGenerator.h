@@ -142,6 +142,11 @@ static const uint32 NICF_USE_WORKREGS = 0x00040000;
 
 static const uint32 NCIF_BREAKPOINT = 0x00080000;
 
+// operand patched at runtime, mParam is the patch id
+static const uint32 NCIF_SELF_MODIFIED = 0x00100000;
+// store into the operand of the patched instruction mParam, mAddress selects the byte
+static const uint32 NCIF_SELF_PATCH = 0x00200000;
+
 class NativeCodeInstruction
 {
 public:
@@ -259,6 +264,7 @@ public:
 	ExpandingArray<NativeCodeBasicBlock*>	mEntryBlocks;
 
 	int							mOffset, mSize, mPlace, mNumEntries, mNumEntered, mFrameOffset, mTemp;
+	int							mDomNum, mDomEnd, mLoopDepth;
 	bool						mPlaced, mCopied, mKnownShortBranch, mBypassed, mAssembled, mNoFrame, mVisited, mLoopHead, mVisiting, mLocked, mPatched, mPatchFail, mPatchChecked, mPatchStart, mPatchLoop, mPatchLoopChanged, mPatchExit;
 	bool						mEntryRegA, mEntryRegX, mEntryRegY, mExitRegA, mExitRegX, mChecked;
 	NativeCodeBasicBlock	*	mDominator, * mSameBlock;
@@ -298,6 +304,11 @@ public:
 
 	void CopyCode(NativeCodeProcedure* proc, uint8* target);
 	void Assemble(void);
+
+	uint32 BuildLateLiveRegs(void);
+	bool Optimize65C02(void);
+	bool Optimize6502X(void);
+	bool PatchPointerLoop(NativeCodeBasicBlock* pblock);
 	void Close(const InterInstruction * ins, NativeCodeBasicBlock* trueJump, NativeCodeBasicBlock* falseJump, AsmInsType branch);
 
 	void PrependInstruction(const NativeCodeInstruction& ins);
@@ -450,13 +461,6 @@ public:
 
 	void MarkLoopHead(void);
 
-	struct DominatorStacks
-	{
-		ExpandingArray< NativeCodeBasicBlock* >	d1, d2;
-	};
-
-	void BuildDominatorTree(NativeCodeBasicBlock * from, DominatorStacks & stacks);
-
 	bool MoveLoadStoreUp(int at);
 	bool MoveLoadStoreXUp(int at);
 	bool MoveLoadImmStoreAbsoluteUp(int at);
@@ -694,6 +698,7 @@ public:
 	bool ApplyEntryDataSet(void);
 
 	bool CollectZeroPageSet(ZeroPageSet& locals, ZeroPageSet& global, bool ignorefcall);
+	void CollectChangedCPURegs(uint32& regs);
 	void CollectZeroPageUsage(NumberSet& used, NumberSet& modified, NumberSet& pairs);
 	void FindZeroPageAlias(const NumberSet& statics, NumberSet& invalid, uint8* alias, int accu);
 	bool RemapZeroPage(const uint8* remap);
@@ -880,12 +885,18 @@ class NativeCodeProcedure
 		ExpandingArray< NativeCodeBasicBlock*>	 mBlocks;
 		ExpandingArray<CodeLocation>		mCodeLocations;
 
+		ExpandingArray<NativeCodeBasicBlock*>	mPatchBlocks;
+		ExpandingArray<int>						mPatchOffsets;
+
 
 		void DisassembleDebug(const char* name);
 		void Disassemble(FILE* file);
 
 		void Compile(InterCodeProcedure* proc);
 		void Optimize(void);
+		void BuildLateLiveRegs(ExpandingArray<NativeCodeBasicBlock*>& blocks);
+		void OptimizeCPUExtensions(void);
+		void OptimizeSelfModifyingLoops(void);
 		void Assemble(void);
 
 		void AddToSuffixTree(NativeCodeMapper& mapper, SuffixTree* tree);
@@ -950,6 +961,7 @@ public:
 	void PopulateShortMulTables(void);
 
 	Runtime& ResolveRuntime(const Ident* ident);
+	bool HasRuntime(const Ident* ident) const;
 
 	Errors* mErrors;
 	Linker* mLinker;
@@ -220,6 +220,15 @@ bool NumberSet::operator<=(const NumberSet& set) const
 
 
 
+uint64 NumberSet::Hash(uint64 hash) const
+{
+	hash = (hash ^ size) * 0x9e3779b97f4a7c15ULL;
+	for (int i = 0; i < dwsize; i++)
+		hash = (hash ^ (hash >> 29) ^ bits[i]) * 0x9e3779b97f4a7c15ULL;
+
+	return hash;
+}
+
 FastNumberSet::FastNumberSet(void)
 {
 	num = 0;
@@ -31,6 +31,8 @@ public:
 
 	bool operator<=(const NumberSet& set) const;
 
+	uint64 Hash(uint64 hash) const;
+
 	void OrNot(const NumberSet& set);
 
 	void Clear(void);
@@ -12431,6 +12431,10 @@ Expression* Parser::ParseAssembler(Declaration* vdasm)
 							else
 								mErrors->Error(mScanner->mLocation, EERR_SYNTAX, "',y' expected");
 						}
+						else if (!HasAsmInstructionMode(ilast->mAsmInsType, ASMIM_INDIRECT) && HasAsmInstructionMode(ilast->mAsmInsType, ASMIM_ZERO_PAGE_INDIRECT))
+						{
+							ilast->mAsmInsMode = ASMIM_ZERO_PAGE_INDIRECT;
+						}
 						else
 						{
 							ilast->mAsmInsMode = ASMIM_INDIRECT;
@@ -13551,6 +13555,10 @@ void Parser::ParsePragma(void)
 						mCompilerOptions |= COPT_OPTIMIZE_OUTLINE;
 					else if (ConsumeIdentIf("nooutline"))
 						mCompilerOptions &= ~COPT_OPTIMIZE_OUTLINE;
+					else if (ConsumeIdentIf("selfmodify"))
+						mCompilerOptions |= COPT_OPTIMIZE_SELF_MODIFY;
+					else if (ConsumeIdentIf("noselfmodify"))
+						mCompilerOptions &= ~COPT_OPTIMIZE_SELF_MODIFY;
 					else
 						mErrors->Error(mScanner->mLocation, EERR_INVALID_IDENTIFIER, "Invalid option");
 
@@ -176,6 +176,188 @@ const char* TokenNames[] =
 	"'decltype'",
 };
 
+// Keywords, preprocessor directives and embed decoders are found with a
+// perfect hash over the identifier hash, that is computed while the
+// characters are collected and reused to intern the identifier
+
+static const uint32 KWF_CPLUSPLUS = 0x00000001;
+static const uint32 KWF_EMBED_MODE = 0x00000002;
+
+struct ScannerKeyword
+{
+	const char	*	mName;
+	int				mValue;
+	uint32			mFlags;
+};
+
+static const ScannerKeyword IdentKeywordList[] = {
+	{"true", TK_TRUE, 0},
+	{"false", TK_FALSE, 0},
+	{"nullptr", TK_NULL, 0},
+	{"int", TK_INT, 0},
+	{"float", TK_FLOAT, 0},
+	{"bool", TK_BOOL, 0},
+	{"_Bool", TK_BOOL, 0},
+	{"char", TK_CHAR, 0},
+	{"short", TK_SHORT, 0},
+	{"long", TK_LONG, 0},
+	{"unsigned", TK_UNSIGNED, 0},
+	{"signed", TK_SIGNED, 0},
+	{"const", TK_CONST, 0},
+	{"volatile", TK_VOLATILE, 0},
+	{"if", TK_IF, 0},
+	{"else", TK_ELSE, 0},
+	{"while", TK_WHILE, 0},
+	{"do", TK_DO, 0},
+	{"for", TK_FOR, 0},
+	{"switch", TK_SWITCH, 0},
+	{"case", TK_CASE, 0},
+	{"default", TK_DEFAULT, 0},
+	{"break", TK_BREAK, 0},
+	{"continue", TK_CONTINUE, 0},
+	{"return", TK_RETURN, 0},
+	{"goto", TK_GOTO, 0},
+	{"void", TK_VOID, 0},
+	{"struct", TK_STRUCT, 0},
+	{"union", TK_UNION, 0},
+	{"enum", TK_ENUM, 0},
+	{"sizeof", TK_SIZEOF, 0},
+	{"__bankof", TK_BANKOF, 0},
+	{"typedef", TK_TYPEDEF, 0},
+	{"static", TK_STATIC, 0},
+	{"auto", TK_AUTO, 0},
+	{"extern", TK_EXTERN, 0},
+	{"inline", TK_INLINE, 0},
+	{"__asm", TK_ASM, 0},
+	{"__assume", TK_ASSUME, 0},
+	{"__interrupt", TK_INTERRUPT, 0},
+	{"__hwinterrupt", TK_HWINTERRUPT, 0},
+	{"__native", TK_NATIVE, 0},
+	{"__fastcall", TK_FASTCALL, 0},
+	{"__export", TK_EXPORT, 0},
+	{"__zeropage", TK_ZEROPAGE, 0},
+	{"__noinline", TK_NOINLINE, 0},
+	{"__forceinline", TK_FORCEINLINE, 0},
+	{"__striped", TK_STRIPED, 0},
+	{"__dynstack", TK_DYNSTACK, 0},
+	{"namespace", TK_NAMESPACE, KWF_CPLUSPLUS},
+	{"using", TK_USING, KWF_CPLUSPLUS},
+	{"this", TK_THIS, KWF_CPLUSPLUS},
+	{"class", TK_CLASS, KWF_CPLUSPLUS},
+	{"public", TK_PUBLIC, KWF_CPLUSPLUS},
+	{"protected", TK_PROTECTED, KWF_CPLUSPLUS},
+	{"private", TK_PRIVATE, KWF_CPLUSPLUS},
+	{"new", TK_NEW, KWF_CPLUSPLUS},
+	{"delete", TK_DELETE, KWF_CPLUSPLUS},
+	{"virtual", TK_VIRTUAL, KWF_CPLUSPLUS},
+	{"template", TK_TEMPLATE, KWF_CPLUSPLUS},
+	{"friend", TK_FRIEND, KWF_CPLUSPLUS},
+	{"constexpr", TK_CONSTEXPR, KWF_CPLUSPLUS},
+	{"typename", TK_TYPENAME, KWF_CPLUSPLUS},
+	{"decltype", TK_DECLTYPE, KWF_CPLUSPLUS},
+	{"operator", TK_OPERATOR, KWF_CPLUSPLUS},
+	{nullptr}
+};
+
+static const ScannerKeyword PrepKeywordList[] = {
+	{"define", TK_PREP_DEFINE, 0},
+	{"error", TK_PREP_ERROR, 0},
+	{"warning", TK_PREP_WARN, 0},
+	{"undef", TK_PREP_UNDEF, 0},
+	{"include", TK_PREP_INCLUDE, 0},
+	{"if", TK_PREP_IF, 0},
+	{"ifdef", TK_PREP_IFDEF, 0},
+	{"ifndef", TK_PREP_IFNDEF, 0},
+	{"elif", TK_PREP_ELIF, 0},
+	{"else", TK_PREP_ELSE, 0},
+	{"endif", TK_PREP_ENDIF, 0},
+	{"pragma", TK_PREP_PRAGMA, 0},
+	{"line", TK_PREP_LINE, 0},
+	{"assign", TK_PREP_ASSIGN, 0},
+	{"repeat", TK_PREP_REPEAT, 0},
+	{"until", TK_PREP_UNTIL, 0},
+	{"embed", TK_PREP_EMBED, 0},
+	{"for", TK_PREP_FOR, 0},
+	{nullptr}
+};
+
+static const ScannerKeyword EmbedKeywordList[] = {
+	{"rle", SFM_BINARY_RLE, KWF_EMBED_MODE},
+	{"lzo", SFM_BINARY_LZO, KWF_EMBED_MODE},
+	{"word", SFM_BINARY_WORD, KWF_EMBED_MODE},
+	{"ctm_chars", SFD_CTM_CHARS, 0},
+	{"ctm_attr1", SFD_CTM_CHAR_ATTRIB_1, 0},
+	{"ctm_attr2", SFD_CTM_CHAR_ATTRIB_2, 0},
+	{"ctm_tiles8", SFD_CTM_TILES_8, 0},
+	{"ctm_tiles8sw", SFD_CTM_TILES_8_SW, 0},
+	{"ctm_tiles16", SFD_CTM_TILES_16, 0},
+	{"ctm_map8", SFD_CTM_MAP_8, 0},
+	{"ctm_map16", SFD_CTM_MAP_16, 0},
+	{"spd_sprites", SFD_SPD_SPRITES, 0},
+	{"spd_tiles", SFD_SPD_TILES, 0},
+	{nullptr}
+};
+
+class ScannerKeywordHash
+{
+public:
+	ScannerKeywordHash(const ScannerKeyword* keywords);
+
+	const ScannerKeyword* Lookup(const char* str, int length, unsigned int hash) const
+	{
+		int	slot = (hash * mMultiplier) >> (32 - KeywordHashBits);
+		if (mLengths[slot] == length && !memcmp(mSlots[slot]->mName, str, length))
+			return mSlots[slot];
+		else
+			return nullptr;
+	}
+
+protected:
+	static const int	KeywordHashBits = 9;
+
+	const ScannerKeyword	*	mSlots[1 << KeywordHashBits];
+	int							mLengths[1 << KeywordHashBits];
+	unsigned int				mMultiplier;
+};
+
+ScannerKeywordHash::ScannerKeywordHash(const ScannerKeyword* keywords)
+{
+	// Search for a multiplier, that places all keywords into distinct slots
+
+	mMultiplier = 0x9e3779b1;
+	for (;;)
+	{
+		for (int i = 0; i < (1 << KeywordHashBits); i++)
+		{
+			mSlots[i] = nullptr;
+			mLengths[i] = -1;
+		}
+
+		int	i = 0;
+		while (keywords[i].mName)
+		{
+			unsigned int	hash = Ident::HashSeed;
+			int				length = 0;
+			while (keywords[i].mName[length])
+				hash = Ident::HashChar(hash, keywords[i].mName[length++]);
+
+			int	slot = (hash * mMultiplier) >> (32 - KeywordHashBits);
+			if (mSlots[slot])
+				break;
+			mSlots[slot] = keywords + i;
+			mLengths[slot] = length;
+			i++;
+		}
+
+		if (!keywords[i].mName)
+			return;
+
+		mMultiplier += 2;
+	}
+}
+
+static const ScannerKeywordHash	IdentKeywords(IdentKeywordList), PrepKeywords(PrepKeywordList), EmbedKeywords(EmbedKeywordList);
+
 
 Macro::Macro(const Ident* ident, MacroDict * scope)
 	: mIdent(ident), mString(nullptr), mNumArguments(-1), mScope(scope), mVariadic(false)
@@ -964,34 +1146,13 @@ void Scanner::NextPreToken(void)
 
 			while (mToken == TK_IDENT)
 			{
-				if (!strcmp(mTokenIdent->mString, "rle"))
-					mode = SFM_BINARY_RLE;
-				else if (!strcmp(mTokenIdent->mString, "lzo"))
-					mode = SFM_BINARY_LZO;
-				else if (!strcmp(mTokenIdent->mString, "word"))
-					mode = SFM_BINARY_WORD;
-				else if (!strcmp(mTokenIdent->mString, "ctm_chars"))
-					decoder = SFD_CTM_CHARS;
-				else if (!strcmp(mTokenIdent->mString, "ctm_attr1"))
-					decoder = SFD_CTM_CHAR_ATTRIB_1;
-				else if (!strcmp(mTokenIdent->mString, "ctm_attr2"))
-					decoder = SFD_CTM_CHAR_ATTRIB_2;
-				else if (!strcmp(mTokenIdent->mString, "ctm_tiles8"))
-					decoder = SFD_CTM_TILES_8;
-				else if (!strcmp(mTokenIdent->mString, "ctm_tiles8sw"))
-					decoder = SFD_CTM_TILES_8_SW;
-				else if (!strcmp(mTokenIdent->mString, "ctm_tiles16"))
-					decoder = SFD_CTM_TILES_16;
-				else if (!strcmp(mTokenIdent->mString, "ctm_map8"))
-					decoder = SFD_CTM_MAP_8;
-				else if (!strcmp(mTokenIdent->mString, "ctm_map16"))
-					decoder = SFD_CTM_MAP_16;
-				else if (!strcmp(mTokenIdent->mString, "spd_sprites"))
-					decoder = SFD_SPD_SPRITES;
-				else if (!strcmp(mTokenIdent->mString, "spd_tiles"))
-					decoder = SFD_SPD_TILES;
-				else
+				const ScannerKeyword* kw = EmbedKeywords.Lookup(mTokenIdent->mString, int(strlen(mTokenIdent->mString)), mTokenIdent->mHash);
+				if (!kw)
 					mErrors->Error(mLocation, EERR_FILE_NOT_FOUND, "Invalid embed compression mode", mTokenIdent);
+				else if (kw->mFlags & KWF_EMBED_MODE)
+					mode = SourceFileMode(kw->mValue);
+				else
+					decoder = SourceFileDecoder(kw->mValue);
 
 				NextPreToken();
 			}
@@ -1198,53 +1359,24 @@ void Scanner::NextSkipRawToken(void)
 				char	tkprep[128];
 				tkprep[0] = 0;
 
+				unsigned int	hash = Ident::HashSeed;
 				while (NextChar() && IsAlpha(mTokenChar))
 				{
 					if (n < 127)
+					{
 						tkprep[n++] = mTokenChar;
+						hash = Ident::HashChar(hash, mTokenChar);
+					}
 				}
 				tkprep[n] = 0;
 
-				if (!strcmp(tkprep, "define"))
-					mToken = TK_PREP_DEFINE;
-				else if (!strcmp(tkprep, "error"))
-					mToken = TK_PREP_ERROR;
-				else if (!strcmp(tkprep, "warning"))
-					mToken = TK_PREP_WARN;
-				else if (!strcmp(tkprep, "undef"))
-					mToken = TK_PREP_UNDEF;
-				else if (!strcmp(tkprep, "include"))
-					mToken = TK_PREP_INCLUDE;
-				else if (!strcmp(tkprep, "if"))
-					mToken = TK_PREP_IF;
-				else if (!strcmp(tkprep, "ifdef"))
-					mToken = TK_PREP_IFDEF;
-				else if (!strcmp(tkprep, "ifndef"))
-					mToken = TK_PREP_IFNDEF;
-				else if (!strcmp(tkprep, "elif"))
-					mToken = TK_PREP_ELIF;
-				else if (!strcmp(tkprep, "else"))
-					mToken = TK_PREP_ELSE;
-				else if (!strcmp(tkprep, "endif"))
-					mToken = TK_PREP_ENDIF;
-				else if (!strcmp(tkprep, "pragma"))
-					mToken = TK_PREP_PRAGMA;
-				else if (!strcmp(tkprep, "line"))
-					mToken = TK_PREP_LINE;
-				else if (!strcmp(tkprep, "assign"))
-					mToken = TK_PREP_ASSIGN;
-				else if (!strcmp(tkprep, "repeat"))
-					mToken = TK_PREP_REPEAT;
-				else if (!strcmp(tkprep, "until"))
-					mToken = TK_PREP_UNTIL;
-				else if (!strcmp(tkprep, "embed"))
-					mToken = TK_PREP_EMBED;
-				else if (!strcmp(tkprep, "for"))
-					mToken = TK_PREP_FOR;
+				const ScannerKeyword* kw = PrepKeywords.Lookup(tkprep, n, hash);
+				if (kw)
+					mToken = Token(kw->mValue);
 				else
 				{
 					mToken = TK_PREP_IDENT;
-					mTokenIdent = Ident::Unique(tkprep);
+					mTokenIdent = Ident::UniqueHashed(tkprep, hash);
 				}
 			}
 			else
@@ -1590,53 +1722,24 @@ void Scanner::NextRawToken(void)
 				char	tkprep[128];
 				tkprep[0] = 0;
 
+				unsigned int	hash = Ident::HashSeed;
 				while (NextChar() && IsAlpha(mTokenChar))
 				{
 					if (n < 127)
+					{
 						tkprep[n++] = mTokenChar;
+						hash = Ident::HashChar(hash, mTokenChar);
+					}
 				}
 				tkprep[n] = 0;
 
-				if (!strcmp(tkprep, "define"))
-					mToken = TK_PREP_DEFINE;
-				else if (!strcmp(tkprep, "error"))
-					mToken = TK_PREP_ERROR;
-				else if (!strcmp(tkprep, "warning"))
-					mToken = TK_PREP_WARN;
-				else if (!strcmp(tkprep, "undef"))
-					mToken = TK_PREP_UNDEF;
-				else if (!strcmp(tkprep, "include"))
-					mToken = TK_PREP_INCLUDE;
-				else if (!strcmp(tkprep, "if"))
-					mToken = TK_PREP_IF;
-				else if (!strcmp(tkprep, "ifdef"))
-					mToken = TK_PREP_IFDEF;
-				else if (!strcmp(tkprep, "ifndef"))
-					mToken = TK_PREP_IFNDEF;
-				else if (!strcmp(tkprep, "elif"))
-					mToken = TK_PREP_ELIF;
-				else if (!strcmp(tkprep, "else"))
-					mToken = TK_PREP_ELSE;
-				else if (!strcmp(tkprep, "endif"))
-					mToken = TK_PREP_ENDIF;
-				else if (!strcmp(tkprep, "pragma"))
-					mToken = TK_PREP_PRAGMA;
-				else if (!strcmp(tkprep, "line"))
-					mToken = TK_PREP_LINE;
-				else if (!strcmp(tkprep, "assign"))
-					mToken = TK_PREP_ASSIGN;
-				else if (!strcmp(tkprep, "repeat"))
-					mToken = TK_PREP_REPEAT;
-				else if (!strcmp(tkprep, "until"))
-					mToken = TK_PREP_UNTIL;
-				else if (!strcmp(tkprep, "embed"))
-					mToken = TK_PREP_EMBED;
-				else if (!strcmp(tkprep, "for"))
-					mToken = TK_PREP_FOR;
+				const ScannerKeyword* kw = PrepKeywords.Lookup(tkprep, n, hash);
+				if (kw)
+					mToken = Token(kw->mValue);
 				else
 				{
 					mToken = TK_PREP_IDENT;
-					mTokenIdent = Ident::Unique(tkprep);
+					mTokenIdent = Ident::UniqueHashed(tkprep, hash);
 				}
 			}
 			else
@@ -1696,12 +1799,16 @@ void Scanner::NextRawToken(void)
 				char	tkident[256];
 				tkident[0] = 0;
 
+				unsigned int	hash = Ident::HashSeed;
 				for (;;)
 				{
 					if (IsIdentChar(mTokenChar))
 					{
 						if (n < 255)
+						{
 							tkident[n++] = mTokenChar;
+							hash = Ident::HashChar(hash, mTokenChar);
+						}
 						NextChar();
 					}
 					else
@@ -1724,133 +1831,13 @@ void Scanner::NextRawToken(void)
 				if (n == 256)
 					Error("Identifier exceeds max character limit");
 
-				if (!strcmp(tkident, "true"))
-					mToken = TK_TRUE;
-				else if (!strcmp(tkident, "false"))
-					mToken = TK_FALSE;
-				else if (!strcmp(tkident, "nullptr"))
-					mToken = TK_NULL;
-				else if (!strcmp(tkident, "int"))
-					mToken = TK_INT;
-				else if (!strcmp(tkident, "float"))
-					mToken = TK_FLOAT;
-				else if (!strcmp(tkident, "bool") || !strcmp(tkident, "_Bool"))
-					mToken = TK_BOOL;
-				else if (!strcmp(tkident, "char"))
-					mToken = TK_CHAR;
-				else if (!strcmp(tkident, "short"))
-					mToken = TK_SHORT;
-				else if (!strcmp(tkident, "long"))
-					mToken = TK_LONG;
-				else if (!strcmp(tkident, "unsigned"))
-					mToken = TK_UNSIGNED;
-				else if (!strcmp(tkident, "signed"))
-					mToken = TK_SIGNED;
-				else if (!strcmp(tkident, "const"))
-					mToken = TK_CONST;
-				else if (!strcmp(tkident, "volatile"))
-					mToken = TK_VOLATILE;
-				else if (!strcmp(tkident, "if"))
-					mToken = TK_IF;
-				else if (!strcmp(tkident, "else"))
-					mToken = TK_ELSE;
-				else if (!strcmp(tkident, "while"))
-					mToken = TK_WHILE;
-				else if (!strcmp(tkident, "do"))
-					mToken = TK_DO;
-				else if (!strcmp(tkident, "for"))
-					mToken = TK_FOR;
-				else if (!strcmp(tkident, "switch"))
-					mToken = TK_SWITCH;
-				else if (!strcmp(tkident, "case"))
-					mToken = TK_CASE;
-				else if (!strcmp(tkident, "default"))
-					mToken = TK_DEFAULT;
-				else if (!strcmp(tkident, "break"))
-					mToken = TK_BREAK;
-				else if (!strcmp(tkident, "continue"))
-					mToken = TK_CONTINUE;
-				else if (!strcmp(tkident, "return"))
-					mToken = TK_RETURN;
-				else if (!strcmp(tkident, "goto"))
-					mToken = TK_GOTO;
-				else if (!strcmp(tkident, "void"))
-					mToken = TK_VOID;
-				else if (!strcmp(tkident, "struct"))
-					mToken = TK_STRUCT;
-				else if (!strcmp(tkident, "union"))
-					mToken = TK_UNION;
-				else if (!strcmp(tkident, "enum"))
-					mToken = TK_ENUM;
-				else if (!strcmp(tkident, "sizeof"))
-					mToken = TK_SIZEOF;
-				else if (!strcmp(tkident, "__bankof"))
-					mToken = TK_BANKOF;
-				else if (!strcmp(tkident, "typedef"))
-					mToken = TK_TYPEDEF;
-				else if (!strcmp(tkident, "static"))
-					mToken = TK_STATIC;
-				else if (!strcmp(tkident, "auto"))
-					mToken = TK_AUTO;
-				else if (!strcmp(tkident, "extern"))
-					mToken = TK_EXTERN;
-				else if (!strcmp(tkident, "inline"))
-					mToken = TK_INLINE;
-				else if (!strcmp(tkident, "__asm"))
-					mToken = TK_ASM;
-				else if (!strcmp(tkident, "__assume"))
-					mToken = TK_ASSUME;
-				else if (!strcmp(tkident, "__interrupt"))
-					mToken = TK_INTERRUPT;
-				else if (!strcmp(tkident, "__hwinterrupt"))
-					mToken = TK_HWINTERRUPT;
-				else if (!strcmp(tkident, "__native"))
-					mToken = TK_NATIVE;
-				else if (!strcmp(tkident, "__fastcall"))
-					mToken = TK_FASTCALL;
-				else if (!strcmp(tkident, "__export"))
-					mToken = TK_EXPORT;
-				else if (!strcmp(tkident, "__zeropage"))
-					mToken = TK_ZEROPAGE;
-				else if (!strcmp(tkident, "__noinline"))
-					mToken = TK_NOINLINE;
-				else if (!strcmp(tkident, "__forceinline"))
-					mToken = TK_FORCEINLINE;
-				else if (!strcmp(tkident, "__striped"))
-					mToken = TK_STRIPED;
-				else if (!strcmp(tkident, "__dynstack"))
-					mToken = TK_DYNSTACK;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "namespace"))
-					mToken = TK_NAMESPACE;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "using"))
-					mToken = TK_USING;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "this"))
-					mToken = TK_THIS;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "class"))
-					mToken = TK_CLASS;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "public"))
-					mToken = TK_PUBLIC;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "protected"))
-					mToken = TK_PROTECTED;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "private"))
-					mToken = TK_PRIVATE;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "new"))
-					mToken = TK_NEW;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "delete"))
-					mToken = TK_DELETE;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "virtual"))
-					mToken = TK_VIRTUAL;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "template"))
-					mToken = TK_TEMPLATE;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "friend"))
-					mToken = TK_FRIEND;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "constexpr"))
-					mToken = TK_CONSTEXPR;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "typename"))
-					mToken = TK_TYPENAME;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "decltype"))
-					mToken = TK_DECLTYPE;
-				else if ((mCompilerOptions & COPT_CPLUSPLUS) && !strcmp(tkident, "operator"))
+				const ScannerKeyword* kw = IdentKeywords.Lookup(tkident, n, hash);
+				if (kw && (!(kw->mFlags & KWF_CPLUSPLUS) || (mCompilerOptions & COPT_CPLUSPLUS)))
+					mToken = Token(kw->mValue);
+				else
+					mToken = TK_IDENT;
+
+				if (mToken == TK_OPERATOR)
 				{
 					NextRawToken();
 					switch (mToken)
@@ -1987,11 +1974,8 @@ void Scanner::NextRawToken(void)
 
 					mToken = TK_IDENT;
 				}
-				else
-				{
-					mToken = TK_IDENT;
-					mTokenIdent = Ident::Unique(tkident);
-				}
+				else if (mToken == TK_IDENT)
+					mTokenIdent = Ident::UniqueHashed(tkident, hash);
 			}
 			else
 			{
@@ -203,6 +203,45 @@ int main2(int argc, const char** argv)
 				{
 					strcpy_s(targetPath, arg + 3);
 				}
+				else if (arg[1] == 'o' && arg[2] == 'f' && arg[3] == '=')
+				{
+					compiler->mOutputFiles = 0;
+
+					const char* ap = arg + 4;
+					while (*ap)
+					{
+						char	ext[10];
+						int		n = 0;
+						while (*ap && *ap != ',')
+						{
+							if (n < 9)
+								ext[n++] = *ap;
+							ap++;
+						}
+						ext[n] = 0;
+						if (*ap == ',')
+							ap++;
+
+						if (!strcmp(ext, "map"))
+							compiler->mOutputFiles |= COUT_MAP;
+						else if (!strcmp(ext, "asm"))
+							compiler->mOutputFiles |= COUT_ASM;
+						else if (!strcmp(ext, "lbl"))
+							compiler->mOutputFiles |= COUT_LBL;
+						else if (!strcmp(ext, "int"))
+							compiler->mOutputFiles |= COUT_INT;
+						else if (!strcmp(ext, "bcs"))
+							compiler->mOutputFiles |= COUT_BCS;
+						else if (!strcmp(ext, "dbj"))
+							compiler->mOutputFiles |= COUT_DBJ;
+						else if (!strcmp(ext, "csz"))
+							compiler->mOutputFiles |= COUT_CSZ;
+						else if (!strcmp(ext, "all"))
+							compiler->mOutputFiles |= COUT_ALL;
+						else if (strcmp(ext, "none"))
+							compiler->mErrors->Error(loc, EERR_COMMAND_LINE, "Invalid output file option", ext);
+					}
+				}
 				else if (arg[1] == 'r' && arg[2] == 't' && arg[3] == '=')
 				{
 					strcpy_s(crtPath, arg + 4);
@@ -225,6 +264,11 @@ int main2(int argc, const char** argv)
 					strcpy_s(cid, arg + 5);
 					compiler->mCartridgeID = atoi(cid);
 				}
+				else if (arg[1] == 'n' && arg[2] == 'b' && arg[3] == '=')
+				{
+					compiler->mNativeBudget = atoi(arg + 4);
+					compiler->mCompilerOptions &= ~COPT_NATIVE;
+				}
 				else if (arg[1] == 'n' && arg[2] == 0)
 				{
 					compiler->mCompilerOptions |= COPT_NATIVE;
@@ -263,6 +307,10 @@ int main2(int argc, const char** argv)
 						compiler->mCompilerOptions |= COPT_OPTIMIZE_MERGE_CALLS;
 					else if (arg[2] == 'o' && !arg[3])
 						compiler->mCompilerOptions |= COPT_OPTIMIZE_OUTLINE;
+					else if (arg[2] == 'x' && !arg[3])
+						compiler->mCompilerOptions |= COPT_OPTIMIZE_SELF_MODIFY;
+					else if (arg[2] == 'b' && !arg[3])
+						compiler->mCompilerOptions |= COPT_OPTIMIZE_BYTECODE_FUSION;
 					else
 						compiler->mErrors->Error(loc, EERR_COMMAND_LINE, "Invalid command line argument", arg);
 				}
@@ -319,6 +367,20 @@ int main2(int argc, const char** argv)
 				{
 					compiler->mCompilerOptions |= COPT_EXTENDED_ZERO_PAGE;
 				}
+				else if (arg[1] == 'x' && arg[2] == 'b' && !arg[3])
+				{
+					compiler->mCompilerOptions |= COPT_BANK_TRAMPOLINES;
+				}
+				else if (arg[1] == 'c' && arg[2] == 'p' && arg[3] == 'u' && arg[4] == '=')
+				{
+					compiler->mCompilerOptions &= ~(COPT_CPU_65C02 | COPT_CPU_6502X);
+					if (!strcmp(arg + 5, "65c02") || !strcmp(arg + 5, "65C02"))
+						compiler->mCompilerOptions |= COPT_CPU_65C02;
+					else if (!strcmp(arg + 5, "6502x") || !strcmp(arg + 5, "6502X"))
+						compiler->mCompilerOptions |= COPT_CPU_6502X;
+					else if (strcmp(arg + 5, "6502"))
+						compiler->mErrors->Error(loc, EERR_COMMAND_LINE, "Invalid cpu option", arg + 5);
+				}
 				else if (arg[1] == 'p' && arg[2] == 'p' && !arg[3])
 				{
 					compiler->mCompilerOptions |= COPT_CPLUSPLUS;
@@ -448,6 +510,8 @@ int main2(int argc, const char** argv)
 		{
 			strcpy_s(basicStart, "0x0801");
 			compiler->mTargetMachine = TMACH_X16;
+			compiler->mCompilerOptions &= ~COPT_CPU_6502X;
+			compiler->mCompilerOptions |= COPT_CPU_65C02;
 			compiler->AddDefine(Ident::Unique("__X16__"), "1");
 		}
 		else if (!strcmp(targetMachine, "nes"))
@@ -478,6 +542,17 @@ int main2(int argc, const char** argv)
 		else
 			compiler->mErrors->Error(loc, EERR_COMMAND_LINE, "Invalid target machine option", targetMachine);
 
+		if (compiler->mCompilerOptions & COPT_CPU_65C02)
+		{
+			InitAssembler65C02();
+			compiler->AddDefine(Ident::Unique("__65C02__"), "1");
+		}
+		else if (compiler->mCompilerOptions & COPT_CPU_6502X)
+		{
+			InitAssembler6502X();
+			compiler->AddDefine(Ident::Unique("__6502X__"), "1");
+		}
+
 
 		if (compiler->mTargetMachine >= TMACH_NES && compiler->mTargetMachine <= TMACH_NES_MMC3)
 		{
@@ -615,7 +690,7 @@ int main2(int argc, const char** argv)
 	}
 	else
 	{
-		printf("oscar64 {-i=includePath} [-o=output.prg] [-rt=runtime.c] [-tf=target] [-tm=machine] [-e] [-n] [-g] [-O(0|1|2|3)] [-pp] {-dSYMBOL[=value]} [-v] [-d64=diskname] {-f[z]=file.xxx} {source.c}\n");
+		printf("oscar64 {-i=includePath} [-o=output.prg] [-of=map,asm,lbl,int,bcs,dbj,csz] [-rt=runtime.c] [-tf=target] [-tm=machine] [-cpu=(6502|6502x|65c02)] [-e] [-n] [-g] [-O(0|1|2|3)] [-pp] {-dSYMBOL[=value]} [-v] [-d64=diskname] {-f[z]=file.xxx} {source.c}\n");
 
 		return 0;
 	}
@@ -10,5 +10,6 @@
 ../../bin/oscar64 easyflashreloc.c -n -tf=crt
 ../../bin/oscar64 easyflashshared.c -n -tf=crt
 ../../bin/oscar64 easyflashcall.cpp -n -tf=crt
+../../bin/oscar64 easyflashauto.c -n -tf=crt -xb
 ../../bin/oscar64 tsr.c -n -dNOFLOAT -dNOLONG
 ../../bin/oscar64 overlay.c -n -d64=overlay.d64
@@ -0,0 +1,106 @@
+#include <c64/memmap.h>
+#include <c64/charwin.h>
+#include <c64/cia.h>
+#include <c64/vic.h>
+#include <c64/easyflash.h>
+
+// Compile with -xb to let the linker insert the bank switching code
+// for direct calls between the banks
+
+// Shared code/data region, copied from easyflash bank 0 to ram during startup
+
+#pragma region( main, 0x0900, 0x8000, , , { code, data, bss, heap, stack } )
+
+// Section and region for first easyflash bank
+
+#pragma section( bcode1, 0 )
+#pragma section( bdata1, 0 )
+#pragma region(bank1, 0x8000, 0xc000, , 1, { bcode1, bdata1 } )
+
+// Section and region for second easyflash bank
+
+#pragma section( bcode2, 0 )
+#pragma section( bdata2, 0 )
+#pragma region(bank2, 0x8000, 0xc000, , 2, { bcode2, bdata2 } )
+
+// A code section spread over banks three and four, the linker keeps
+// functions calling each other in the same bank
+
+#pragma section( bcode34, 0 )
+#pragma region(bank3, 0x8000, 0xc000, , 3, { bcode34 } )
+#pragma region(bank4, 0x8000, 0xc000, , 4, { bcode34 } )
+
+// Charwin in shared memory section
+
+CharWin	cw;
+
+#pragma code ( bcode2 )
+#pragma data ( bdata2 )
+
+void print2(const char * p)
+{
+	cwin_put_string(&cw, p"This is second bank:", 7);
+	cwin_put_string(&cw, p, 1);
+	cwin_cursor_newline(&cw);
+}
+
+#pragma code ( bcode1 )
+#pragma data ( bdata1 )
+
+// Calls into bank two and returns to bank one
+
+void print1(void)
+{
+	cwin_put_string(&cw, p"This is first bank", 7);
+	cwin_cursor_newline(&cw);
+	print2(p"called from first");
+	cwin_put_string(&cw, p"Back in first bank", 7);
+	cwin_cursor_newline(&cw);
+}
+
+#pragma code ( bcode34 )
+#pragma data ( data )
+
+void print3(const char * p)
+{
+	cwin_put_string(&cw, p"This is bank three or four:", 7);
+	cwin_put_string(&cw, p, 1);
+	cwin_cursor_newline(&cw);
+}
+
+void print4(void)
+{
+	print3(p"once");
+	print3(p"twice");
+}
+
+// Switching code generation back to shared section
+
+#pragma code ( code )
+#pragma data ( data )
+
+int main(void)
+{
+	// Enable ROM
+	mmap_set(MMAP_ROM);
+
+	// Init CIAs (no kernal rom was executed so far)
+	cia_init();
+
+	// Init VIC
+	vic_setmode(VICM_TEXT, (char *)0x0400, (char *)0x1800);
+
+	// Prepare output window
+	cwin_init(&cw, (char *)0x0400, 0, 0, 40, 25);
+	cwin_clear(&cw);
+
+	print1();
+	print2(p"called from main");
+	print4();
+
+	// Loop forever
+	while (true)
+		;
+
+	return 0;
+}
@@ -10,6 +10,7 @@ call ..\..\bin\oscar64 easyflashreloc.c -n -tf=crt
 call ..\..\bin\oscar64 easyflashshared.c -n -tf=crt
 call ..\..\bin\oscar64 easyflashlow.c -n -tf=crt
 call ..\..\bin\oscar64 easyflashcall.cpp -n -tf=crt
+call ..\..\bin\oscar64 easyflashauto.c -n -tf=crt -xb
 call ..\..\bin\oscar64 tsr.c -n -dNOFLOAT -dNOLONG
 call ..\..\bin\oscar64 overlay.c -n -d64=overlay.d64
 call ..\..\bin\oscar64 magicdesk.c -n -tf=crt8 -cid=19